@@ -18,6 +18,8 @@
  */
 #include "services/database/Artist.hpp"
 
+#include <algorithm>
+
 #include <Wt/Dbo/WtSqlTraits.h>
 
 #include "services/database/Cluster.hpp"
@@ -66,6 +68,16 @@ Artist::find(Session& session, const std::string& name)
 	return std::vector<Artist::pointer>(res.begin(), res.end());
 }
 
+std::vector<Artist::pointer>
+Artist::findAll(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<Wt::Dbo::ptr<Artist>> res = session.getDboSession().find<Artist>();
+
+	return std::vector<Artist::pointer>(res.begin(), res.end());
+}
+
 Artist::pointer
 Artist::find(Session& session, const UUID& mbid)
 {
@@ -110,7 +122,23 @@ createQuery(Session& session, const Artist::FindParameters& params)
 	if (params.writtenAfter.isValid())
 		query.where("t.file_last_write > ?").bind(params.writtenAfter);
 
-	if (!params.keywords.empty())
+	const std::string keywordsMatchExpression {[&]
+	{
+		const std::string nameMatchExpression {Utils::getFullTextMatchExpression("name", params.keywords)};
+		if (nameMatchExpression.empty())
+			return nameMatchExpression;
+
+		return "(" + nameMatchExpression + ") OR (" + Utils::getFullTextMatchExpression("sort_name", params.keywords) + ")";
+	}()};
+
+	if (!keywordsMatchExpression.empty())
+	{
+		query.join("artist_fts ON artist_fts.rowid = a.id");
+		query.where("artist_fts MATCH ?").bind(keywordsMatchExpression);
+	}
+
+	// The full-text index cannot be used for short keywords: in that case, just check all the keywords on the prefiltered artists
+	if (std::any_of(std::cbegin(params.keywords), std::cend(params.keywords), [](std::string_view keyword) { return !Utils::isFullTextKeyword(keyword); }))
 	{
 		std::vector<std::string> clauses;
 		std::vector<std::string> sortClauses;
@@ -187,6 +215,13 @@ createQuery(Session& session, const Artist::FindParameters& params)
 			assert(params.starringUser.isValid());
 			query.orderBy("s_a.date_time DESC");
 			break;
+		case ArtistSortMethod::Relevance:
+			// Paging needs a stable order: ties are ordered by id, and there is no rank without full-text match (no keywords or short ones only)
+			if (!keywordsMatchExpression.empty())
+				query.orderBy("artist_fts.rank, a.id");
+			else
+				query.orderBy("a.sort_name COLLATE NOCASE, a.id");
+			break;
 	}
 
 	return query;
@@ -201,11 +236,35 @@ Artist::findAllOrphans(Session& session, Range range)
 	return Utils::execQuery(query, range);
 }
 
+static
+bool
+hasFilters(const Artist::FindParameters& params)
+{
+	return !params.clusters.empty()
+		|| !params.keywords.empty()
+		|| params.linkType
+		|| params.writtenAfter.isValid()
+		|| params.starringUser.isValid()
+		|| params.track.isValid()
+		|| params.release.isValid();
+}
+
 RangeResults<ArtistId>
 Artist::find(Session& session, const FindParameters& params)
 {
 	session.checkSharedLocked();
 
+	if (params.sortMethod == ArtistSortMethod::Random && !hasFilters(params))
+	{
+		auto createSamplingQuery {[&]
+		{
+			return createQuery(session, FindParameters {params}.setSortMethod(ArtistSortMethod::None));
+		}};
+
+		if (auto res {Utils::execRandomSamplingQuery<ArtistId>(session.getDboSession(), "artist", "a.id", createSamplingQuery, params.range)})
+			return std::move(*res);
+	}
+
 	auto query {createQuery(session, params)};
 	return Utils::execQuery(query, params.range);
 }
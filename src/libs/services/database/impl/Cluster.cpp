@@ -19,6 +19,8 @@
 
 #include "services/database/Cluster.hpp"
 
+#include <algorithm>
+
 #include "services/database/Artist.hpp"
 #include "services/database/Release.hpp"
 #include "services/database/ScanSettings.hpp"
@@ -68,6 +70,31 @@ Cluster::findOrphans(Session& session, Range range)
 	return Utils::execQuery(query, range);
 }
 
+RangeResults<Cluster::TrackLinkResult>
+Cluster::findTrackLinks(Session& session, Range range)
+{
+	using QueryResultType = std::tuple<ClusterId, TrackId>;
+	session.checkSharedLocked();
+
+	auto query {session.getDboSession().query<QueryResultType>("SELECT cluster_id, track_id FROM track_cluster")
+		.orderBy("cluster_id")};
+
+	RangeResults<QueryResultType> queryResults {Utils::execQuery(query, range)};
+
+	RangeResults<TrackLinkResult> res;
+	res.range = queryResults.range;
+	res.moreResults = queryResults.moreResults;
+	res.results.reserve(queryResults.results.size());
+
+	std::transform(std::cbegin(queryResults.results), std::cend(queryResults.results), std::back_inserter(res.results),
+			[](const QueryResultType& queryResult)
+			{
+				return TrackLinkResult {std::get<0>(queryResult), std::get<1>(queryResult)};
+			});
+
+	return res;
+}
+
 Cluster::pointer
 Cluster::find(Session& session, ClusterId id)
 {
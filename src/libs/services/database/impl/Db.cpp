@@ -19,29 +19,67 @@
 
 #include "services/database/Db.hpp"
 
+#include <Wt/Dbo/Exception.h>
 #include <Wt/Dbo/FixedSqlConnectionPool.h>
-#include <Wt/Dbo/backend/Sqlite3.h>
 
 #include "services/database/Session.hpp"
 #include "services/database/User.hpp"
+#include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
+#include "ReadWriteConnectionPool.hpp"
+#include "Sqlite3Connection.hpp"
 
 namespace Database {
 
+// Enough to hold the fixed-shape queries, while evicting the ones built from variable parameters (keywords, clusters, etc.)
+static constexpr std::size_t maxCachedStatementCountPerConnection {256};
+// Writers are serialized, but a thread may use several sessions
+static constexpr std::size_t writeConnectionCount {2};
+
+static
+std::unique_ptr<Wt::Dbo::SqlConnectionPool>
+createConnectionPool(std::unique_ptr<Wt::Dbo::SqlConnection> connection, std::size_t connectionCount)
+{
+	auto connectionPool {std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), connectionCount)};
+	connectionPool->setTimeout(std::chrono::seconds(10));
+
+	return connectionPool;
+}
+
+// Keyword searches rely on the FTS5 extension and its trigram tokenizer (SQLite >= 3.34)
+// Checked on the SQLite library actually used by Wt::Dbo, which may be a bundled copy
+static
+void
+checkFullTextSearchSupport(Wt::Dbo::SqlConnection& connection)
+{
+	try
+	{
+		connection.executeSql("CREATE VIRTUAL TABLE temp.fts_check USING fts5(value, tokenize='trigram')");
+		connection.executeSql("DROP TABLE temp.fts_check");
+	}
+	catch (const Wt::Dbo::Exception& e)
+	{
+		throw LmsException {"SQLite must be at least version 3.34 and built with FTS5 support (check the SQLite library used by Wt): " + std::string {e.what()}};
+	}
+}
+
 // Session living class handling the database and the login
 Db::Db(const std::filesystem::path& dbPath, std::size_t connectionCount)
 {
-	LMS_LOG(DB, INFO) << "Creating connection pool on file " << dbPath.string();
+	LMS_LOG(DB, INFO) << "Creating connection pools on file " << dbPath.string();
 
-	std::unique_ptr<Wt::Dbo::backend::Sqlite3> connection {std::make_unique<Wt::Dbo::backend::Sqlite3>(dbPath.string())};
-//	connection->setProperty("show-queries", "true");
-	connection->executeSql("pragma journal_mode=WAL");
-	connection->executeSql("pragma synchronous=normal");
+	auto writeConnection {std::make_unique<Sqlite3Connection>(dbPath.string(), maxCachedStatementCountPerConnection, std::vector<std::string> {"synchronous=normal"})};
+//	writeConnection->setProperty("show-queries", "true");
+	// Required as readers are not serialized with writers (see RecursiveWriterMutex)
+	writeConnection->executeSql("pragma journal_mode=WAL");
+	checkFullTextSearchSupport(*writeConnection);
 
-	auto connectionPool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), connectionCount);
-	connectionPool->setTimeout(std::chrono::seconds(10));
+	// Readers only: catch unexpected writes, and use bigger caches
+	auto readConnection {std::make_unique<Sqlite3Connection>(dbPath.string(), maxCachedStatementCountPerConnection, std::vector<std::string> {"query_only=ON", "mmap_size=268435456", "cache_size=-32768"})};
 
-	_connectionPool = std::move(connectionPool);
+	_connectionPool = std::make_unique<ReadWriteConnectionPool>(_writerMutex,
+			createConnectionPool(std::move(writeConnection), writeConnectionCount),
+			createConnectionPool(std::move(readConnection), connectionCount));
 }
 
 Db::~Db()
@@ -54,10 +92,16 @@ Db::~Db()
 void
 Db::executeSql(const std::string& sql)
 {
-	ScopedConnection connection {*_connectionPool};
+	ScopedConnection connection {_connectionPool->getWriteConnectionPool()};
 	connection->executeSql(sql);
 }
 
+Wt::Dbo::SqlConnectionPool&
+Db::getConnectionPool()
+{
+	return *_connectionPool;
+}
+
 Session&
 Db::getTLSSession()
 {
@@ -19,6 +19,10 @@
 
 #include "Migration.hpp"
 
+#include <set>
+#include <tuple>
+#include <vector>
+
 #include <Wt/Dbo/WtSqlTraits.h>
 
 #include "services/database/Db.hpp"
@@ -27,6 +31,7 @@
 #include "services/database/User.hpp"
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
+#include "TrackFeaturesEncoding.hpp"
 
 namespace Database
 {
@@ -611,6 +616,46 @@ CREATE TABLE IF NOT EXISTS "track_artist_link_backup" (
 		ScanSettings::get(session).modify()->incScanVersion();
 	}
 
+	static
+	void
+	migrateFromV38(Session& session)
+	{
+		// Store a compact binary subset of the track features instead of the raw JSON documents, which are discarded
+		// (whether raw data is kept is only decided when fetching new features)
+		session.getDboSession().execute("ALTER TABLE track_features ADD features BLOB");
+
+		static constexpr std::size_t batchSize {100};
+		long long lastId {-1};
+
+		while (true)
+		{
+			using Row = std::tuple<long long, std::string>;
+
+			const auto collection {session.getDboSession().query<Row>("SELECT id, data FROM track_features")
+				.where("id > ?").bind(lastId)
+				.orderBy("id")
+				.limit(static_cast<int>(batchSize))
+				.resultList()};
+			const std::vector<Row> rows(collection.begin(), collection.end());
+
+			for (const auto& [id, data] : rows)
+			{
+				const std::vector<unsigned char> features {encodeTrackFeatures(data)};
+
+				// Make sure the features of this track will be fetched again
+				if (features.empty())
+					session.getDboSession().execute("DELETE FROM track_features WHERE id = ?").bind(id);
+				else
+					session.getDboSession().execute("UPDATE track_features SET features = ?, data = '' WHERE id = ?").bind(features).bind(id);
+			}
+
+			if (rows.size() < batchSize)
+				break;
+
+			lastId = std::get<0>(rows.back());
+		}
+	}
+
 	void
 	doDbMigration(Session& session)
 	{
@@ -618,6 +663,10 @@ CREATE TABLE IF NOT EXISTS "track_artist_link_backup" (
 
 		ScopedNoForeignKeys noPragmaKeys {session.getDb()};
 
+		// Migrations freeing a lot of space: the database file has to be compacted afterwards
+		static const std::set<Version> compactingMigrations {38};
+		bool compactNeeded {};
+
 		using MigrationFunction = std::function<void(Session&)>;
 
 		const std::map<unsigned, MigrationFunction> migrationFunctions
@@ -655,6 +704,7 @@ CREATE TABLE IF NOT EXISTS "track_artist_link_backup" (
 			{35, migrateFromV35},
 			{36, migrateFromV36},
 			{37, migrateFromV37},
+			{38, migrateFromV38},
 		};
 
 		while (1)
@@ -676,7 +726,7 @@ CREATE TABLE IF NOT EXISTS "track_artist_link_backup" (
 			if (version == LMS_DATABASE_VERSION)
 			{
 				LMS_LOG(DB, DEBUG) << "Lms database version " << LMS_DATABASE_VERSION << ": up to date!";
-				return;
+				break;
 			}
 			else if (version > LMS_DATABASE_VERSION)
 			{
@@ -691,8 +741,18 @@ CREATE TABLE IF NOT EXISTS "track_artist_link_backup" (
 			auto itMigrationFunc {migrationFunctions.find(version)};
 			assert(itMigrationFunc != std::cend(migrationFunctions));
 			itMigrationFunc->second(session);
+			if (compactingMigrations.find(version) != std::cend(compactingMigrations))
+				compactNeeded = true;
 
 			VersionInfo::get(session).modify()->setVersion(++version);
 		}
+
+		// Cannot be done within a transaction
+		if (compactNeeded)
+		{
+			LMS_LOG(DB, INFO) << "Compacting database...";
+			session.getDb().executeSql("VACUUM");
+			LMS_LOG(DB, INFO) << "Compacting database DONE";
+		}
 	}
 }
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReadWriteConnectionPool.hpp"
+
+#include <Wt/Dbo/SqlConnection.h>
+
+#include "utils/RecursiveWriterMutex.hpp"
+
+namespace Database
+{
+	ReadWriteConnectionPool::ReadWriteConnectionPool(const RecursiveWriterMutex& writerMutex, std::unique_ptr<Wt::Dbo::SqlConnectionPool> writeConnectionPool, std::unique_ptr<Wt::Dbo::SqlConnectionPool> readConnectionPool)
+	: _writerMutex {writerMutex}
+	, _writeConnectionPool {std::move(writeConnectionPool)}
+	, _readConnectionPool {std::move(readConnectionPool)}
+	{
+	}
+
+	ReadWriteConnectionPool::~ReadWriteConnectionPool() = default;
+
+	std::unique_ptr<Wt::Dbo::SqlConnection>
+	ReadWriteConnectionPool::getConnection()
+	{
+		// Connections are requested when the Dbo transactions are opened, with the writer mutex already locked
+		// Dbo transactions opened without any lock (should not happen) use a write connection, as they may write
+		if (_writerMutex.isUniqueLocked() || !_writerMutex.isSharedLocked())
+			return _writeConnectionPool->getConnection();
+
+		std::unique_ptr<Wt::Dbo::SqlConnection> connection {_readConnectionPool->getConnection()};
+		{
+			std::scoped_lock lock {_mutex};
+			_readConnections.insert(connection.get());
+		}
+
+		return connection;
+	}
+
+	void
+	ReadWriteConnectionPool::returnConnection(std::unique_ptr<Wt::Dbo::SqlConnection> connection)
+	{
+		bool isReadConnection {};
+		{
+			std::scoped_lock lock {_mutex};
+			isReadConnection = _readConnections.erase(connection.get()) > 0;
+		}
+
+		if (isReadConnection)
+			_readConnectionPool->returnConnection(std::move(connection));
+		else
+			_writeConnectionPool->returnConnection(std::move(connection));
+	}
+
+	void
+	ReadWriteConnectionPool::prepareForDropTables() const
+	{
+		_writeConnectionPool->prepareForDropTables();
+		_readConnectionPool->prepareForDropTables();
+	}
+} // namespace Database
+
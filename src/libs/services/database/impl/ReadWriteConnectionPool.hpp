@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+
+class RecursiveWriterMutex;
+
+namespace Database
+{
+	// Hands out connections from the write pool to the threads holding the writer mutex (unique transactions),
+	// and from the read pool to the threads only holding a shared lock (shared transactions)
+	class ReadWriteConnectionPool : public Wt::Dbo::SqlConnectionPool
+	{
+		public:
+			ReadWriteConnectionPool(const RecursiveWriterMutex& writerMutex, std::unique_ptr<Wt::Dbo::SqlConnectionPool> writeConnectionPool, std::unique_ptr<Wt::Dbo::SqlConnectionPool> readConnectionPool);
+			~ReadWriteConnectionPool() override;
+
+			ReadWriteConnectionPool(const ReadWriteConnectionPool&) = delete;
+			ReadWriteConnectionPool(ReadWriteConnectionPool&&) = delete;
+			ReadWriteConnectionPool& operator=(const ReadWriteConnectionPool&) = delete;
+			ReadWriteConnectionPool& operator=(ReadWriteConnectionPool&&) = delete;
+
+			Wt::Dbo::SqlConnectionPool& getWriteConnectionPool() { return *_writeConnectionPool; }
+
+			std::unique_ptr<Wt::Dbo::SqlConnection>	getConnection() override;
+			void									returnConnection(std::unique_ptr<Wt::Dbo::SqlConnection> connection) override;
+			void									prepareForDropTables() const override;
+
+		private:
+			const RecursiveWriterMutex&						_writerMutex;
+			std::unique_ptr<Wt::Dbo::SqlConnectionPool>		_writeConnectionPool;
+			std::unique_ptr<Wt::Dbo::SqlConnectionPool>		_readConnectionPool;
+
+			// Used to return the connections to the pool they come from
+			std::mutex										_mutex;
+			std::unordered_set<const Wt::Dbo::SqlConnection*>	_readConnections;
+	};
+} // namespace Database
+
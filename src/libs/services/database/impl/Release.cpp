@@ -56,8 +56,17 @@ createQuery(Session& session, const Release::FindParameters& params)
 		query.where("t.date <= ?").bind(params.dateRange->end);
 	}
 
+	const std::string keywordsMatchExpression {Utils::getFullTextMatchExpression("name", params.keywords)};
+	if (!keywordsMatchExpression.empty())
+	{
+		query.join("release_fts ON release_fts.rowid = r.id");
+		query.where("release_fts MATCH ?").bind(keywordsMatchExpression);
+	}
 	for (std::string_view keyword : params.keywords)
-		query.where("r.name LIKE ? ESCAPE '" ESCAPE_CHAR_STR "'").bind("%" + Utils::escapeLikeKeyword(keyword) + "%");
+	{
+		if (!Utils::isFullTextKeyword(keyword))
+			query.where("r.name LIKE ? ESCAPE '" ESCAPE_CHAR_STR "'").bind("%" + Utils::escapeLikeKeyword(keyword) + "%");
+	}
 
 	if (params.starringUser.isValid())
 	{
@@ -161,6 +170,13 @@ createQuery(Session& session, const Release::FindParameters& params)
 			assert(params.starringUser.isValid());
 			query.orderBy("s_r.date_time DESC");
 			break;
+		case ReleaseSortMethod::Relevance:
+			// Paging needs a stable order: ties are ordered by id, and there is no rank without full-text match (no keywords or short ones only)
+			if (!keywordsMatchExpression.empty())
+				query.orderBy("release_fts.rank, r.id");
+			else
+				query.orderBy("r.name COLLATE NOCASE, r.id");
+			break;
 	}
 
 	return query;
@@ -191,6 +207,18 @@ Release::find(Session& session, const std::string& name)
 	return std::vector<Release::pointer>(res.begin(), res.end());
 }
 
+std::vector<Release::pointer>
+Release::findAll(Session& session)
+{
+	session.checkSharedLocked();
+
+	auto res {session.getDboSession()
+						.find<Release>()
+						.resultList()};
+
+	return std::vector<Release::pointer>(res.begin(), res.end());
+}
+
 Release::pointer
 Release::find(Session& session, const UUID& mbid)
 {
@@ -253,11 +281,34 @@ Release::findOrphans(Session& session, Range range)
 	return Utils::execQuery(query, range);
 }
 
+static
+bool
+hasFilters(const Release::FindParameters& params)
+{
+	return !params.clusters.empty()
+		|| !params.keywords.empty()
+		|| params.writtenAfter.isValid()
+		|| params.dateRange
+		|| params.starringUser.isValid()
+		|| params.artist.isValid();
+}
+
 RangeResults<ReleaseId>
 Release::find(Session& session, const FindParameters& params)
 {
 	session.checkSharedLocked();
 
+	if (params.sortMethod == ReleaseSortMethod::Random && !hasFilters(params))
+	{
+		auto createSamplingQuery {[&]
+		{
+			return createQuery(session, FindParameters {params}.setSortMethod(ReleaseSortMethod::None));
+		}};
+
+		if (auto res {Utils::execRandomSamplingQuery<ReleaseId>(session.getDboSession(), "release", "r.id", createSamplingQuery, params.range)})
+			return std::move(*res);
+	}
+
 	auto query {createQuery(session, params)};
 
 	return Utils::execQuery(query, params.range);
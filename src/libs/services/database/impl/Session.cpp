@@ -20,9 +20,12 @@
 #include "services/database/Session.hpp"
 
 #include <cassert>
+#include <string>
+#include <vector>
 
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
+#include "utils/String.hpp"
 
 #include "services/database/Artist.hpp"
 #include "services/database/AuthToken.hpp"
@@ -45,6 +48,44 @@
 namespace Database
 {
 
+// External content full-text index on the given columns of the given table, kept up to date using triggers
+// The trigram tokenizer allows substring searches, like the LIKE '%keyword%' clauses (requires SQLite >= 3.34)
+static
+void
+createFullTextIndex(Wt::Dbo::Session& session, const std::string& table, const std::vector<std::string>& columns)
+{
+	const std::string ftsTable {table + "_fts"};
+
+	const bool exists {session.query<int>("SELECT COUNT(*) FROM sqlite_master").where("type = 'table'").where("name = ?").bind(ftsTable).resultValue() > 0};
+
+	std::vector<std::string> oldColumns;
+	std::vector<std::string> newColumns;
+	std::vector<std::string> changedColumns;
+	for (const std::string& column : columns)
+	{
+		oldColumns.push_back("old." + column);
+		newColumns.push_back("new." + column);
+		changedColumns.push_back("old." + column + " IS NOT new." + column);
+	}
+
+	const std::string columnList {StringUtils::joinStrings(columns, ",")};
+	const std::string deleteEntry {"INSERT INTO " + ftsTable + "(" + ftsTable + ",rowid," + columnList + ") VALUES('delete',old.id," + StringUtils::joinStrings(oldColumns, ",") + ");"};
+	const std::string insertEntry {"INSERT INTO " + ftsTable + "(rowid," + columnList + ") VALUES(new.id," + StringUtils::joinStrings(newColumns, ",") + ");"};
+
+	session.execute("CREATE VIRTUAL TABLE IF NOT EXISTS " + ftsTable + " USING fts5(" + columnList + ", content='" + table + "', content_rowid='id', tokenize='trigram')");
+	session.execute("CREATE TRIGGER IF NOT EXISTS " + ftsTable + "_insert AFTER INSERT ON " + table + " BEGIN " + insertEntry + " END");
+	session.execute("CREATE TRIGGER IF NOT EXISTS " + ftsTable + "_delete AFTER DELETE ON " + table + " BEGIN " + deleteEntry + " END");
+	// Objects are saved as a whole: only update the index on actual changes
+	session.execute("CREATE TRIGGER IF NOT EXISTS " + ftsTable + "_update AFTER UPDATE OF " + columnList + " ON " + table
+			+ " WHEN " + StringUtils::joinStrings(changedColumns, " OR ") + " BEGIN " + deleteEntry + " " + insertEntry + " END");
+
+	if (!exists)
+	{
+		LMS_LOG(DB, INFO) << "Building full-text index '" << ftsTable << "'...";
+		session.execute("INSERT INTO " + ftsTable + "(" + ftsTable + ") VALUES('rebuild')");
+	}
+}
+
 Session::Session(Db& db)
 : _db {db}
 {
@@ -70,13 +111,13 @@ Session::Session(Db& db)
 	_session.mapClass<User>("user");
 }
 
-UniqueTransaction::UniqueTransaction(RecursiveSharedMutex& mutex, Wt::Dbo::Session& session)
+UniqueTransaction::UniqueTransaction(RecursiveWriterMutex& mutex, Wt::Dbo::Session& session)
 : _lock {mutex},
  _transaction {session}
 {
 }
 
-SharedTransaction::SharedTransaction(RecursiveSharedMutex& mutex, Wt::Dbo::Session& session)
+SharedTransaction::SharedTransaction(RecursiveWriterMutex& mutex, Wt::Dbo::Session& session)
 : _lock {mutex},
  _transaction {session}
 {
@@ -112,6 +153,7 @@ Session::prepareTables()
 	// Creation case
 	try
 	{
+		auto uniqueTransaction {createUniqueTransaction()};
 		_session.createTables();
 
 		LMS_LOG(DB, INFO) << "Tables created";
@@ -167,6 +209,14 @@ Session::prepareTables()
 		_session.execute("CREATE INDEX IF NOT EXISTS starred_track_track_user_scrobbler_idx ON starred_track(track_id,user_id,scrobbler)");
 	}
 
+	// Full-text indexes, used for keyword searches
+	{
+		auto uniqueTransaction {createUniqueTransaction()};
+		createFullTextIndex(_session, "artist", {"name", "sort_name"});
+		createFullTextIndex(_session, "release", {"name"});
+		createFullTextIndex(_session, "track", {"name"});
+	}
+
 	// Initial settings tables
 	{
 		auto uniqueTransaction {createUniqueTransaction()};
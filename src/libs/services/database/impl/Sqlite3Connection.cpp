@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Sqlite3Connection.hpp"
+
+#include <Wt/Dbo/SqlStatement.h>
+
+#include "utils/Logger.hpp"
+
+namespace Database
+{
+	namespace
+	{
+		constexpr std::size_t statsLogPeriod {10'000};
+	}
+
+	Sqlite3Connection::Sqlite3Connection(const std::string& dbPath, std::size_t maxCachedStatementCount, const std::vector<std::string>& pragmas)
+	: Wt::Dbo::backend::Sqlite3 {dbPath}
+	, _maxCachedStatementCount {maxCachedStatementCount}
+	, _pragmas {pragmas}
+	{
+		applyPragmas();
+	}
+
+	Sqlite3Connection::Sqlite3Connection(const Sqlite3Connection& other)
+	: Wt::Dbo::backend::Sqlite3 {other}
+	, _maxCachedStatementCount {other._maxCachedStatementCount}
+	, _pragmas {other._pragmas}
+	{
+		applyPragmas();
+	}
+
+	Sqlite3Connection::~Sqlite3Connection()
+	{
+		if (_hitCount + _missCount > 0)
+			logStats();
+	}
+
+	std::unique_ptr<Wt::Dbo::SqlConnection>
+	Sqlite3Connection::clone() const
+	{
+		return std::make_unique<Sqlite3Connection>(*this);
+	}
+
+	Wt::Dbo::SqlStatement*
+	Sqlite3Connection::getStatement(const std::string& id)
+	{
+		Wt::Dbo::SqlStatement* res {};
+
+		const auto [itBegin, itEnd] {_cachedStatementsById.equal_range(id)};
+		for (auto it {itBegin}; it != itEnd; ++it)
+		{
+			CachedStatementList::iterator itStatement {it->second};
+			if (itStatement->statement->use())
+			{
+				_cachedStatements.splice(std::begin(_cachedStatements), _cachedStatements, itStatement);
+				res = itStatement->statement.get();
+				break;
+			}
+		}
+
+		if (res)
+			_hitCount++;
+		else
+			_missCount++; // Dbo will prepare a new statement and save it
+
+		if ((_hitCount + _missCount) % statsLogPeriod == 0)
+			logStats();
+
+		return res;
+	}
+
+	void
+	Sqlite3Connection::saveStatement(const std::string& id, std::unique_ptr<Wt::Dbo::SqlStatement> statement)
+	{
+		_cachedStatements.push_front(CachedStatement {id, std::move(statement)});
+		_cachedStatementsById.emplace(id, std::begin(_cachedStatements));
+
+		evictStatements();
+	}
+
+	void
+	Sqlite3Connection::applyPragmas()
+	{
+		for (const std::string& pragma : _pragmas)
+			executeSql("pragma " + pragma);
+	}
+
+	void
+	Sqlite3Connection::evictStatements()
+	{
+		auto it {std::end(_cachedStatements)};
+		while (_cachedStatements.size() > _maxCachedStatementCount && it != std::begin(_cachedStatements))
+		{
+			--it;
+
+			// Statements in use cannot be finalized (use() only succeeds if the statement is not in use)
+			if (!it->statement->use())
+				continue;
+
+			const auto [itBegin, itEnd] {_cachedStatementsById.equal_range(it->id)};
+			for (auto itById {itBegin}; itById != itEnd; ++itById)
+			{
+				if (itById->second == it)
+				{
+					_cachedStatementsById.erase(itById);
+					break;
+				}
+			}
+
+			it = _cachedStatements.erase(it);
+			_evictionCount++;
+		}
+	}
+
+	void
+	Sqlite3Connection::logStats() const
+	{
+		const std::size_t lookupCount {_hitCount + _missCount};
+
+		LMS_LOG(DB, DEBUG) << "Statement cache: " << _cachedStatements.size() << "/" << _maxCachedStatementCount << " statement(s), "
+			<< lookupCount << " lookup(s), hit rate = " << (lookupCount ? (_hitCount * 100 / lookupCount) : 0) << "%, "
+			<< _evictionCount << " eviction(s)";
+	}
+} // namespace Database
+
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Wt/Dbo/backend/Sqlite3.h>
+
+namespace Database
+{
+	// Sqlite3 connection that bounds its prepared statement cache (least recently used statements are finalized first)
+	// Statements are keyed by their SQL text, so only fixed-shape queries are reused
+	// The given pragmas are applied on each new connection, including the cloned ones
+	// Like any connection, must be used by a single session at a time
+	class Sqlite3Connection : public Wt::Dbo::backend::Sqlite3
+	{
+		public:
+			Sqlite3Connection(const std::string& dbPath, std::size_t maxCachedStatementCount, const std::vector<std::string>& pragmas = {});
+			~Sqlite3Connection() override;
+
+			Sqlite3Connection(const Sqlite3Connection& other);
+			Sqlite3Connection(Sqlite3Connection&&) = delete;
+			Sqlite3Connection& operator=(const Sqlite3Connection&) = delete;
+			Sqlite3Connection& operator=(Sqlite3Connection&&) = delete;
+
+			std::unique_ptr<Wt::Dbo::SqlConnection> clone() const override;
+
+			Wt::Dbo::SqlStatement*	getStatement(const std::string& id) override;
+			void					saveStatement(const std::string& id, std::unique_ptr<Wt::Dbo::SqlStatement> statement) override;
+
+		private:
+			void applyPragmas();
+			void evictStatements();
+			void logStats() const;
+
+			struct CachedStatement
+			{
+				std::string									id;
+				std::unique_ptr<Wt::Dbo::SqlStatement>		statement;
+			};
+			using CachedStatementList = std::list<CachedStatement>;
+
+			const std::size_t				_maxCachedStatementCount;
+			const std::vector<std::string>	_pragmas;
+
+			// Most recently used first
+			CachedStatementList	_cachedStatements;
+			// The same query may have several statements if it is used recursively
+			std::unordered_multimap<std::string, CachedStatementList::iterator> _cachedStatementsById;
+
+			std::size_t	_hitCount {};
+			std::size_t	_missCount {};
+			std::size_t	_evictionCount {};
+	};
+} // namespace Database
+
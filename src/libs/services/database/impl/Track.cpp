@@ -46,8 +46,17 @@ createQuery(Session& session, const Track::FindParameters& params)
 	auto query {session.getDboSession().query<TrackId>(params.distinct ? "SELECT DISTINCT t.id FROM track t" : "SELECT t.id FROM track t")};
 
 	assert(params.keywords.empty() || params.name.empty());
+	const std::string keywordsMatchExpression {Utils::getFullTextMatchExpression("name", params.keywords)};
+	if (!keywordsMatchExpression.empty())
+	{
+		query.join("track_fts ON track_fts.rowid = t.id");
+		query.where("track_fts MATCH ?").bind(keywordsMatchExpression);
+	}
 	for (std::string_view keyword : params.keywords)
-		query.where("t.name LIKE ? ESCAPE '" ESCAPE_CHAR_STR "'").bind("%" + Utils::escapeLikeKeyword(keyword) + "%");
+	{
+		if (!Utils::isFullTextKeyword(keyword))
+			query.where("t.name LIKE ? ESCAPE '" ESCAPE_CHAR_STR "'").bind("%" + Utils::escapeLikeKeyword(keyword) + "%");
+	}
 
 	if (!params.name.empty())
 		query.where("t.name = ?").bind(params.name);
@@ -159,6 +168,14 @@ createQuery(Session& session, const Track::FindParameters& params)
 		case TrackSortMethod::TrackList:
 			assert(params.trackList.isValid());
 			query.orderBy("t_l.id");
+			break;
+		case TrackSortMethod::Relevance:
+			// Paging needs a stable order: ties are ordered by id, and there is no rank without full-text match (no keywords or short ones only)
+			if (!keywordsMatchExpression.empty())
+				query.orderBy("track_fts.rank, t.id");
+			else
+				query.orderBy("t.id");
+			break;
 	}
 
 	return query;
@@ -246,6 +263,111 @@ Track::findPaths(Session& session, Range range)
 	return res;
 }
 
+static
+RangeResults<Track::FileInfoResult>
+execFileInfosQuery(Wt::Dbo::Query<std::tuple<TrackId, std::string, Wt::WDateTime, int>>& query, Range range)
+{
+	using QueryResultType = std::tuple<TrackId, std::string, Wt::WDateTime, int>;
+
+	RangeResults<QueryResultType> queryResults {Utils::execQuery(query, range)};
+
+	RangeResults<Track::FileInfoResult> res;
+	res.range = queryResults.range;
+	res.moreResults = queryResults.moreResults;
+	res.results.reserve(queryResults.results.size());
+
+	std::transform(std::cbegin(queryResults.results), std::cend(queryResults.results), std::back_inserter(res.results),
+			[](const QueryResultType& queryResult)
+			{
+				return Track::FileInfoResult {std::get<0>(queryResult), std::get<1>(queryResult), std::get<2>(queryResult), static_cast<std::size_t>(std::get<3>(queryResult))};
+			});
+
+	return res;
+}
+
+RangeResults<Track::FileInfoResult>
+Track::findFileInfos(Session& session, Range range)
+{
+	session.checkSharedLocked();
+
+	auto query {session.getDboSession().query<std::tuple<TrackId, std::string, Wt::WDateTime, int>>("SELECT id, file_path, file_last_write, scan_version FROM track")};
+
+	return execFileInfosQuery(query, range);
+}
+
+RangeResults<Track::FileInfoResult>
+Track::findFileInfos(Session& session, const std::filesystem::path& path, Range range)
+{
+	session.checkSharedLocked();
+
+	std::string pathStr {path.string()};
+	while (pathStr.size() > 1 && pathStr.back() == '/')
+		pathStr.pop_back();
+
+	// Range on the children, so that the file_path index can be used: "dir/" <= file_path < "dir0" ('0' follows '/')
+	const std::string childrenBegin {pathStr.back() == '/' ? pathStr : pathStr + "/"};
+	const std::string childrenEnd {childrenBegin.substr(0, childrenBegin.size() - 1) + "0"};
+
+	auto query {session.getDboSession().query<std::tuple<TrackId, std::string, Wt::WDateTime, int>>("SELECT id, file_path, file_last_write, scan_version FROM track")
+		.where("file_path = ? OR (file_path >= ? AND file_path < ?)").bind(pathStr).bind(childrenBegin).bind(childrenEnd)};
+
+	return execFileInfosQuery(query, range);
+}
+
+RangeResults<Track::LinksResult>
+Track::findLinks(Session& session, Range range)
+{
+	using QueryResultType = std::tuple<TrackId, ReleaseId, ArtistId, TrackArtistLinkType>;
+	session.checkSharedLocked();
+
+	auto query {session.getDboSession().query<QueryResultType>("SELECT t.id, t.release_id, t_a_l.artist_id, t_a_l.type FROM track t LEFT JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id")
+		.orderBy("t.id")};
+
+	RangeResults<QueryResultType> queryResults {Utils::execQuery(query, range)};
+
+	RangeResults<LinksResult> res;
+	res.range = queryResults.range;
+	res.moreResults = queryResults.moreResults;
+	res.results.reserve(queryResults.results.size());
+
+	std::transform(std::cbegin(queryResults.results), std::cend(queryResults.results), std::back_inserter(res.results),
+			[](const QueryResultType& queryResult)
+			{
+				return LinksResult {std::get<0>(queryResult), std::get<1>(queryResult), std::get<2>(queryResult), std::get<3>(queryResult)};
+			});
+
+	return res;
+}
+
+std::vector<Track::LinksResult>
+Track::findLinks(Session& session, const std::vector<TrackId>& trackIds)
+{
+	using QueryResultType = std::tuple<TrackId, ReleaseId, ArtistId, TrackArtistLinkType>;
+	session.checkSharedLocked();
+
+	std::vector<LinksResult> res;
+	if (trackIds.empty())
+		return res;
+
+	std::ostringstream oss;
+	oss << "t.id IN (";
+	for (std::size_t i {}; i < trackIds.size(); ++i)
+		oss << (i == 0 ? "?" : ", ?");
+	oss << ")";
+
+	auto query {session.getDboSession().query<QueryResultType>("SELECT t.id, t.release_id, t_a_l.artist_id, t_a_l.type FROM track t LEFT JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id")};
+	query.where(oss.str());
+	for (const TrackId trackId : trackIds)
+		query.bind(trackId);
+
+	auto queryResults {query.orderBy("t.id").resultList()};
+
+	for (const QueryResultType& queryResult : queryResults)
+		res.push_back(LinksResult {std::get<0>(queryResult), std::get<1>(queryResult), std::get<2>(queryResult), std::get<3>(queryResult)});
+
+	return res;
+}
+
 RangeResults<TrackId>
 Track::findRecordingMBIDDuplicates(Session& session, Range range)
 {
@@ -288,11 +410,40 @@ Track::getClusterIds() const
 	return std::vector<ClusterId>(res.begin(), res.end());
 }
 
+static
+bool
+hasFilters(const Track::FindParameters& params)
+{
+	return !params.clusters.empty()
+		|| !params.keywords.empty()
+		|| !params.name.empty()
+		|| params.writtenAfter.isValid()
+		|| params.starringUser.isValid()
+		|| params.artist.isValid()
+		|| !params.artistName.empty()
+		|| params.nonRelease
+		|| params.release.isValid()
+		|| !params.releaseName.empty()
+		|| params.trackList.isValid()
+		|| params.trackNumber;
+}
+
 RangeResults<TrackId>
 Track::find(Session& session, const FindParameters& parameters)
 {
 	session.checkSharedLocked();
 
+	if (parameters.sortMethod == TrackSortMethod::Random && !hasFilters(parameters))
+	{
+		auto createSamplingQuery {[&]
+		{
+			return createQuery(session, FindParameters {parameters}.setSortMethod(TrackSortMethod::None));
+		}};
+
+		if (auto res {Utils::execRandomSamplingQuery<TrackId>(session.getDboSession(), "track", "t.id", createSamplingQuery, parameters.range)})
+			return std::move(*res);
+	}
+
 	auto query {createQuery(session, parameters)};
 
 	return Utils::execQuery(query, parameters.range);
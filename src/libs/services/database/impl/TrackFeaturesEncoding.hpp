@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2018 Emeric Poupon
+ * Copyright (C) 2022 Emeric Poupon
  *
  * This file is part of LMS.
  *
@@ -20,11 +20,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
-class UUID;
-
-namespace AcousticBrainz
+namespace Database
 {
-	std::string extractLowLevelFeatures(const UUID& recordingMBID);
+	// Extracts the stored features from AcousticBrainz low level data
+	// Returns an empty buffer if the features cannot be extracted
+	std::vector<unsigned char> encodeTrackFeatures(const std::string& jsonEncodedFeatures);
 }
 
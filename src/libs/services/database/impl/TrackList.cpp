@@ -315,6 +315,7 @@ TrackList::getArtists(const std::vector<ClusterId>& clusterIds, std::optional<Tr
 			break;
 		case ArtistSortMethod::LastWritten:
 		case ArtistSortMethod::StarredDateDesc:
+		case ArtistSortMethod::Relevance:
 			assert(false); // Not implemented!
 			break;
 	}
@@ -19,6 +19,8 @@
 
 #include "Utils.hpp"
 
+#include <algorithm>
+
 #include "utils/String.hpp"
 
 namespace Database::Utils
@@ -29,6 +31,37 @@ namespace Database::Utils
 		return StringUtils::escapeString(keyword, "%_", escapeChar);
 	}
 
+	bool
+	isFullTextKeyword(std::string_view keyword)
+	{
+		// count UTF-8 characters, not bytes
+		const auto characterCount {std::count_if(std::cbegin(keyword), std::cend(keyword), [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; })};
+		return static_cast<std::size_t>(characterCount) >= minFullTextKeywordSize;
+	}
+
+	std::string
+	getFullTextMatchExpression(std::string_view column, const std::vector<std::string_view>& keywords)
+	{
+		std::string expression;
+
+		for (std::string_view keyword : keywords)
+		{
+			if (!isFullTextKeyword(keyword))
+				continue;
+
+			if (!expression.empty())
+				expression += " AND ";
+
+			// quoted as strings to disable the FTS5 query syntax
+			expression += "\"" + StringUtils::escapeString(keyword, "\"", '"') + "\"";
+		}
+
+		if (expression.empty())
+			return expression;
+
+		return "{" + std::string {column} + "} : (" + expression + ")";
+	}
+
 	Wt::WDateTime
 	normalizeDateTime(const Wt::WDateTime& dateTime)
 	{
@@ -19,13 +19,20 @@
 
 #pragma once
 
+#include <functional>
+#include <optional>
+#include <random>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
 
 #include <Wt/Dbo/Dbo.h>
 #include <Wt/WDateTime.h>
 
 #include "services/database/Types.hpp"
+#include "utils/Random.hpp"
 
 namespace Database::Utils
 {
@@ -33,6 +40,12 @@ namespace Database::Utils
 	static inline constexpr char escapeChar {'\\'};
 	std::string escapeLikeKeyword(std::string_view keywords);
 
+	// Full-text indexes use the trigram tokenizer: shorter keywords must be looked up using LIKE
+	static inline constexpr std::size_t minFullTextKeywordSize {3};
+	bool isFullTextKeyword(std::string_view keyword);
+	// Matches all the full-text keywords on the given column (empty if there is no such keyword)
+	std::string getFullTextMatchExpression(std::string_view column, const std::vector<std::string_view>& keywords);
+
 	template <typename T>
 	RangeResults<T>
 	execQuery(Wt::Dbo::Query<T>& query, Range range)
@@ -81,6 +94,55 @@ namespace Database::Utils
 		return res;
 	}
 
+	// Picks random results without sorting the whole result set (unlike ORDER BY RANDOM()), using the first result whose id follows a random id
+	// Results that follow large id gaps are more likely to be picked: only use it on unfiltered queries
+	// (filtered results come in blocks of contiguous ids, the first result of each block would be picked most of the time)
+	// Returns std::nullopt if the range is not handled or if the picks keep failing, which means the result set is small: it is then cheap to just sort it randomly
+	template <typename IdType>
+	std::optional<RangeResults<IdType>>
+	execRandomSamplingQuery(Wt::Dbo::Session& session, const std::string& table, const std::string& idColumn, const std::function<Wt::Dbo::Query<IdType>()>& createQuery, Range range)
+	{
+		using ValueType = typename IdType::ValueType;
+
+		// pagination makes no sense for random results
+		if (range.offset || !range.size)
+			return std::nullopt;
+
+		const auto [minId, maxId] {session.query<std::tuple<ValueType, ValueType>>("SELECT COALESCE(MIN(id), 0), COALESCE(MAX(id), -1) FROM " + table).resultValue()};
+
+		RangeResults<IdType> res;
+		if (minId <= maxId)
+		{
+			std::uniform_int_distribution<ValueType> dist {minId, maxId};
+			std::unordered_set<IdType> pickedIds;
+			std::size_t failedPickCount {};
+
+			while (res.results.size() < range.size)
+			{
+				auto query {createQuery()};
+				query.where(idColumn + " >= ?").bind(dist(Random::getRandGenerator()))
+					.orderBy(idColumn)
+					.limit(1);
+
+				const IdType pickedId {query.resultValue()};
+				if (!pickedId.isValid() || !pickedIds.insert(pickedId).second)
+				{
+					if (++failedPickCount > range.size)
+						return std::nullopt;
+
+					continue;
+				}
+
+				res.results.push_back(pickedId);
+			}
+		}
+
+		res.moreResults = (res.results.size() == range.size);
+		res.range.offset = range.offset;
+		res.range.size = res.results.size();
+		return res;
+	}
+
 	Wt::WDateTime normalizeDateTime(const Wt::WDateTime& dateTime);
 } // namespace Database::Utils
 
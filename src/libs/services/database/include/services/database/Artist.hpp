@@ -83,6 +83,7 @@ class Artist : public Object<Artist, ArtistId>
 		static pointer					find(Session& session, const UUID& MBID);
 		static pointer					find(Session& session, ArtistId id);
 		static std::vector<pointer>		find(Session& session, const std::string& name);		// exact match on name field
+		static std::vector<pointer>		findAll(Session& session);
 		static RangeResults<ArtistId>	find(Session& session, const FindParameters& parameters);
 		static RangeResults<ArtistId>	findAllOrphans(Session& session, Range range); // No track related
 		static bool						exists(Session& session, ArtistId id);
@@ -43,11 +43,18 @@ class Cluster : public Object<Cluster, ClusterId>
 	public:
 		Cluster() = default;
 
+		struct TrackLinkResult
+		{
+			ClusterId	clusterId;
+			TrackId		trackId;
+		};
+
 		// Find utility
 		static std::size_t				getCount(Session& session);
 		static RangeResults<ClusterId>	find(Session& session, Range range);
 		static pointer					find(Session& session, ClusterId id);
 		static RangeResults<ClusterId>	findOrphans(Session& session, Range range);
+		static RangeResults<TrackLinkResult>	findTrackLinks(Session& session, Range range); // ordered by cluster id
 
 		// Accessors
 		const std::string&				getName() const		{ return _name; }
@@ -23,15 +23,16 @@
 
 #include <Wt/Dbo/SqlConnectionPool.h>
 
-#include "utils/RecursiveSharedMutex.hpp"
+#include "utils/RecursiveWriterMutex.hpp"
 
 namespace Database {
 
+class ReadWriteConnectionPool;
 class Session;
 class Db
 {
 	public:
-		Db(const std::filesystem::path& dbPath, std::size_t connectionCount = 10);
+		Db(const std::filesystem::path& dbPath, std::size_t connectionCount = 10); // connectionCount: for readers only
 		~Db();
 
 		Db(const Db&) = delete;
@@ -46,8 +47,8 @@ class Db
 	private:
 		friend class Session;
 
-		RecursiveSharedMutex&		getMutex() { return _sharedMutex; }
-		Wt::Dbo::SqlConnectionPool&	getConnectionPool() { return *_connectionPool; }
+		RecursiveWriterMutex&		getMutex() { return _writerMutex; }
+		Wt::Dbo::SqlConnectionPool&	getConnectionPool();
 
 		class ScopedConnection
 		{
@@ -67,8 +68,9 @@ class Db
 				std::unique_ptr<Wt::Dbo::SqlConnection> _connection;
 		};
 
-		RecursiveSharedMutex				_sharedMutex;
-		std::unique_ptr<Wt::Dbo::SqlConnectionPool>	_connectionPool;
+		// Only serializes writers: readers rely on the snapshot isolation provided by the WAL mode
+		RecursiveWriterMutex				_writerMutex;
+		std::unique_ptr<ReadWriteConnectionPool>	_connectionPool; // unique transactions use the write connections
 
 		std::mutex _tlsSessionsMutex;
 		std::vector<std::unique_ptr<Session>> _tlsSessions;
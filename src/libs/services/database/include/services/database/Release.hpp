@@ -85,6 +85,7 @@ class Release : public Object<Release, ReleaseId>
 		static bool						exists(Session& session, ReleaseId id);
 		static pointer					find(Session& session, const UUID& MBID);
 		static std::vector<pointer>		find(Session& session, const std::string& name);
+		static std::vector<pointer>		findAll(Session& session);
 		static pointer					find(Session& session, ReleaseId id);
 		static RangeResults<ReleaseId>	find(Session& session, const FindParameters& parameters);
 		static RangeResults<ReleaseId>	findOrphans(Session& session, Range range); // no track related
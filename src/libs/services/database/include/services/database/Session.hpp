@@ -22,7 +22,7 @@
 #include <Wt/Dbo/Dbo.h>
 #include <Wt/Dbo/SqlConnectionPool.h>
 
-#include "utils/RecursiveSharedMutex.hpp"
+#include "utils/RecursiveWriterMutex.hpp"
 #include "services/database/Object.hpp"
 
 
@@ -32,9 +32,9 @@ namespace Database
 	{
 		private:
 			friend class Session;
-			UniqueTransaction(RecursiveSharedMutex& mutex, Wt::Dbo::Session& session);
+			UniqueTransaction(RecursiveWriterMutex& mutex, Wt::Dbo::Session& session);
 
-			std::unique_lock<RecursiveSharedMutex> _lock;
+			std::unique_lock<RecursiveWriterMutex> _lock;
 			Wt::Dbo::Transaction _transaction;
 	};
 
@@ -42,9 +42,9 @@ namespace Database
 	{
 		private:
 			friend class Session;
-			SharedTransaction(RecursiveSharedMutex& mutex, Wt::Dbo::Session& session);
+			SharedTransaction(RecursiveWriterMutex& mutex, Wt::Dbo::Session& session);
 
-			std::shared_lock<RecursiveSharedMutex> _lock;
+			std::shared_lock<RecursiveWriterMutex> _lock;
 			Wt::Dbo::Transaction _transaction;
 	};
 
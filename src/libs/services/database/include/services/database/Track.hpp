@@ -102,6 +102,23 @@ class Track : public Object<Track, TrackId>
 			std::filesystem::path	path;
 		};
 
+		struct FileInfoResult
+		{
+			TrackId					trackId;
+			std::filesystem::path	path;
+			Wt::WDateTime			lastWriteTime;
+			std::size_t				scanVersion;
+		};
+
+		// One entry per track artist link, artistId is invalid for tracks without artist links
+		struct LinksResult
+		{
+			TrackId					trackId;
+			ReleaseId				releaseId;
+			ArtistId				artistId;
+			TrackArtistLinkType		linkType;
+		};
+
 		Track() = default;
 
 		// Find utility functions
@@ -114,6 +131,10 @@ class Track : public Object<Track, TrackId>
 
 		static RangeResults<TrackId>	find(Session& session, const FindParameters& parameters);
 		static RangeResults<PathResult>	findPaths(Session& session, Range range);
+		static RangeResults<FileInfoResult>	findFileInfos(Session& session, Range range);
+		static RangeResults<FileInfoResult>	findFileInfos(Session& session, const std::filesystem::path& path, Range range); // the file itself or the files located in the directory
+		static RangeResults<LinksResult>	findLinks(Session& session, Range range); // ordered by track id
+		static std::vector<LinksResult>		findLinks(Session& session, const std::vector<TrackId>& trackIds); // ordered by track id, trackIds must be kept below the SQLite bound parameter limit
 		static RangeResults<TrackId>	findRecordingMBIDDuplicates(Session& session, Range range);
 		static RangeResults<TrackId>	findWithRecordingMBIDAndMissingFeatures(Session& session, Range range);
 
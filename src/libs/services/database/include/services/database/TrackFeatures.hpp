@@ -42,36 +42,74 @@ using FeatureName = std::string;
 using FeatureValues  = std::vector<double>;
 using FeatureValuesMap = std::unordered_map<FeatureName, FeatureValues>;
 
+struct FeatureDef
+{
+	FeatureName	name;
+	std::size_t	nbDimensions {};
+};
+
 class TrackFeatures : public Object<TrackFeatures, TrackFeaturesId>
 {
 	public:
 		TrackFeatures() = default;
 
+		struct EncodedFeaturesResult
+		{
+			TrackFeaturesId				id;
+			TrackId						trackId;
+			std::vector<unsigned char>	features; // use decodeFeatureValuesMap to get the values
+		};
+
+		struct IdsResult
+		{
+			TrackFeaturesId				id;
+			TrackId						trackId;
+		};
+
 		// Find utilities
 		static std::size_t						getCount(Session& session);
 		static pointer							find(Session& session, TrackFeaturesId id);
 		static pointer							find(Session& session, TrackId trackId);
 		static RangeResults<TrackFeaturesId>	find(Session& session, Range range);
+		static RangeResults<TrackId>			findTrackIds(Session& session, Range range); // tracks having features
+		static RangeResults<IdsResult>			findIds(Session& session, Range range);
+		// Ordered by id, starting after lastRetrievedId (from the start if invalid)
+		static std::vector<EncodedFeaturesResult>	findEncodedFeatures(Session& session, TrackFeaturesId lastRetrievedId, std::size_t count);
+		// Ordered by id, ids must be kept below the SQLite bound parameter limit
+		static std::vector<EncodedFeaturesResult>	findEncodedFeatures(Session& session, const std::vector<TrackFeaturesId>& ids);
+
+		// Features extracted from the AcousticBrainz low level data and stored for each track, in storage order
+		// Changing this list requires a database migration
+		static const std::vector<FeatureDef>&	getFeatureDefs();
+
+		// Extracts the stored features from AcousticBrainz low level data
+		// Returns an empty buffer if the features cannot be extracted: such features must not be stored
+		static std::vector<unsigned char>		encodeFeatures(const std::string& jsonEncodedFeatures);
 
 		FeatureValues		getFeatureValues(const FeatureName& feature) const;
 		FeatureValuesMap	getFeatureValuesMap(const std::unordered_set<FeatureName>& featureNames) const;
 
+		// Does not need any database access, can be called from any thread
+		static FeatureValuesMap	decodeFeatureValuesMap(const std::vector<unsigned char>& encodedFeatures, const std::unordered_set<FeatureName>& featureNames);
+
 		// Accessors
 		Wt::Dbo::ptr<Track> getTrack() const { return _track; }
 
 		template<class Action>
 		void persist(Action& a)
 		{
-			Wt::Dbo::field(a, _data,	"data");
+			Wt::Dbo::field(a, _data,		"data");
+			Wt::Dbo::field(a, _features,	"features");
 			Wt::Dbo::belongsTo(a, _track, "track", Wt::Dbo::OnDeleteCascade);
 		}
 
 	private:
 		friend class Session;
-		TrackFeatures(ObjectPtr<Track> track, const std::string& jsonEncodedFeatures);
-		static pointer create(Session& session, ObjectPtr<Track> track, const std::string& jsonEncodedFeatures);
+		TrackFeatures(ObjectPtr<Track> track, const std::vector<unsigned char>& encodedFeatures, const std::string& rawData);
+		static pointer create(Session& session, ObjectPtr<Track> track, const std::vector<unsigned char>& encodedFeatures, const std::string& rawData = "");
 
-		std::string _data;
+		std::string					_data; // raw AcousticBrainz low level data, only kept on demand
+		std::vector<unsigned char>	_features; // float values of the features, in storage order
 		Wt::Dbo::ptr<Track> _track;
 };
 
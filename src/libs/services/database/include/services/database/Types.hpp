@@ -91,6 +91,7 @@ namespace Database
 		Random,
 		LastWritten,
 		StarredDateDesc,
+		Relevance, // best keyword matches first
 	};
 
 	enum class ReleaseSortMethod
@@ -102,6 +103,7 @@ namespace Database
 		Random,
 		LastWritten,
 		StarredDateDesc,
+		Relevance, // best keyword matches first
 	};
 
 	enum class TrackListSortMethod
@@ -121,6 +123,7 @@ namespace Database
 		DateDescAndRelease,
 		Release, // order by disc/track number
 		TrackList, // order by asc order in tracklist
+		Relevance, // best keyword matches first
 	};
 
 	enum class TrackArtistLinkType
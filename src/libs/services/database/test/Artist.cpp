@@ -254,6 +254,10 @@ TEST_F(DatabaseFixture, Artist_findByName)
 
 		EXPECT_TRUE(Artist::find(session, "NNN").empty());
 		EXPECT_EQ(Artist::find(session, "AAA").size(), 1);
+
+		const auto allArtists {Artist::findAll(session)};
+		ASSERT_EQ(allArtists.size(), 1);
+		EXPECT_EQ(allArtists.front()->getId(), artist.getId());
 	}
 }
 
@@ -140,6 +140,11 @@ TEST_F(DatabaseFixture, Cluster_singleTrack)
 		auto clusterIds {track->getClusterIds()};
 		ASSERT_EQ(clusterIds.size(), 1);
 		EXPECT_EQ(clusterIds.front(), cluster1.getId());
+
+		auto trackLinks {Cluster::findTrackLinks(session, Range {})};
+		ASSERT_EQ(trackLinks.results.size(), 1);
+		EXPECT_EQ(trackLinks.results.front().clusterId, cluster1.getId());
+		EXPECT_EQ(trackLinks.results.front().trackId, track.getId());
 	}
 }
 
@@ -370,6 +375,10 @@ TEST_F(DatabaseFixture, SingleTrackSingleArtistMultiClusters)
 
 		EXPECT_TRUE(Artist::find(session, Artist::FindParameters {}.setClusters({cluster2.getId()})).results.empty());
 		EXPECT_TRUE(Artist::find(session, Artist::FindParameters {}.setClusters({cluster3.getId()})).results.empty());
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
 
 		cluster2.get().modify()->addTrack(track.get());
 	}
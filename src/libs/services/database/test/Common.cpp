@@ -102,6 +102,39 @@ DatabaseFixture::testDatabaseEmpty()
 	EXPECT_EQ(User::getCount(session), 0);
 }
 
+TEST(Database, prepareTablesOnNewDatabase)
+{
+	using namespace Database;
+
+	TmpDatabase tmpDb;
+	Session session {tmpDb.getDb()};
+
+	session.prepareTables();
+	// Must be idempotent
+	session.prepareTables();
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		EXPECT_TRUE(ScanSettings::get(session));
+		EXPECT_EQ(Track::getCount(session), 0);
+		EXPECT_TRUE(Track::find(session, Track::FindParameters {}.setKeywords({"Track"})).results.empty());
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		auto track {session.create<Track>("/path/to/track.mp3")};
+		track.modify()->setName("MyTrack");
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		EXPECT_EQ(Track::find(session, Track::FindParameters {}.setKeywords({"Track"})).results.size(), 1);
+	}
+}
+
 TEST_F(DatabaseFixture, Common_subRangeEmpty)
 {
 	using namespace Database;
@@ -291,7 +291,7 @@ TEST_F(DatabaseFixture, Listen_getTopReleases)
 	const Wt::WDateTime dateTime {Wt::WDate{2000, 1, 2}, Wt::WTime{12,0, 1}};
 	ScopedRelease release {session, "MyRelease"};
 	{
-		auto transaction {session.createSharedTransaction()};
+		auto transaction {session.createUniqueTransaction()};
 		track.get().modify()->setRelease(release.get());
 	}
 
@@ -333,7 +333,7 @@ TEST_F(DatabaseFixture, Listen_getTopReleases_multi)
 	ScopedRelease release2 {session, "MyRelease2"};
 
 	{
-		auto transaction {session.createSharedTransaction()};
+		auto transaction {session.createUniqueTransaction()};
 		track1.get().modify()->setRelease(release1.get());
 		track2.get().modify()->setRelease(release2.get());
 	}
@@ -381,7 +381,7 @@ TEST_F(DatabaseFixture, Listen_getTopReleases_cluster)
 	ScopedRelease release {session, "MyRelease"};
 
 	{
-		auto transaction {session.createSharedTransaction()};
+		auto transaction {session.createUniqueTransaction()};
 		track.get().modify()->setRelease(release.get());
 	}
 
@@ -652,7 +652,7 @@ TEST_F(DatabaseFixture, Listen_getRecentReleases)
 	ScopedRelease release {session, "MyRelease"};
 
 	{
-		auto transaction {session.createSharedTransaction()};
+		auto transaction {session.createUniqueTransaction()};
 		track.get().modify()->setRelease(release.get());
 	}
 
@@ -693,7 +693,7 @@ TEST_F(DatabaseFixture, Listen_getRecentReleases_multi)
 	ScopedRelease release2 {session, "MyRelease2"};
 
 	{
-		auto transaction {session.createSharedTransaction()};
+		auto transaction {session.createUniqueTransaction()};
 		track1.get().modify()->setRelease(release1.get());
 		track2.get().modify()->setRelease(release2.get());
 	}
@@ -753,7 +753,7 @@ TEST_F(DatabaseFixture, Listen_getRecentReleases_cluster)
 	ScopedRelease release {session, "MyRelease"};
 
 	{
-		auto transaction {session.createSharedTransaction()};
+		auto transaction {session.createUniqueTransaction()};
 		track.get().modify()->setRelease(release.get());
 	}
 	{
@@ -39,6 +39,12 @@ TEST_F(DatabaseFixture, Release)
 		EXPECT_EQ(Release::getCount(session), 1);
 		EXPECT_TRUE(Release::exists(session, release.getId()));
 
+		{
+			const auto releases {Release::findAll(session)};
+			ASSERT_EQ(releases.size(), 1);
+			EXPECT_EQ(releases.front()->getId(), release.getId());
+		}
+
 		{
 			auto releases {Release::findOrphans(session, Range {})};
 			ASSERT_EQ(releases.results.size(), 1);
@@ -20,6 +20,9 @@
 #include "Common.hpp"
 
 #include <algorithm>
+#include <list>
+#include <map>
+#include <set>
 
 using namespace Database;
 
@@ -46,6 +49,136 @@ TEST_F(DatabaseFixture, Track)
 	}
 }
 
+TEST_F(DatabaseFixture, Track_findFileInfos)
+{
+	ScopedTrack track {session, "/foo/MyTrackFile"};
+
+	const Wt::WDateTime lastWriteTime {Wt::WDate {2021, 10, 3}, Wt::WTime {21, 45, 12}};
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		track.get().modify()->setLastWriteTime(lastWriteTime);
+		track.get().modify()->setScanVersion(5);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const auto fileInfos {Track::findFileInfos(session, Range {})};
+		ASSERT_EQ(fileInfos.results.size(), 1);
+		EXPECT_EQ(fileInfos.results.front().trackId, track.getId());
+		EXPECT_EQ(fileInfos.results.front().path, "/foo/MyTrackFile");
+		EXPECT_EQ(fileInfos.results.front().lastWriteTime, lastWriteTime);
+		EXPECT_EQ(fileInfos.results.front().scanVersion, 5);
+	}
+}
+
+TEST_F(DatabaseFixture, Track_findFileInfosInDirectory)
+{
+	ScopedTrack track1 {session, "/root/dir/track1.mp3"};
+	ScopedTrack track2 {session, "/root/dir/subdir/track2.mp3"};
+	ScopedTrack track3 {session, "/root/dir2/track3.mp3"};
+	ScopedTrack track4 {session, "/root/dir.mp3"};
+
+	auto findTrackIds {[&](const std::filesystem::path& path)
+	{
+		std::set<TrackId> res;
+		for (const Track::FileInfoResult& fileInfo : Track::findFileInfos(session, path, Range {}).results)
+			res.insert(fileInfo.trackId);
+		return res;
+	}};
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		EXPECT_EQ(findTrackIds("/root/dir"), (std::set<TrackId> {track1.getId(), track2.getId()}));
+		EXPECT_EQ(findTrackIds("/root/dir/"), (std::set<TrackId> {track1.getId(), track2.getId()}));
+		EXPECT_EQ(findTrackIds("/root/dir/subdir"), (std::set<TrackId> {track2.getId()}));
+		EXPECT_EQ(findTrackIds("/root/dir.mp3"), (std::set<TrackId> {track4.getId()}));
+		EXPECT_EQ(findTrackIds("/root"), (std::set<TrackId> {track1.getId(), track2.getId(), track3.getId(), track4.getId()}));
+		EXPECT_TRUE(findTrackIds("/root/unknown").empty());
+	}
+}
+
+TEST_F(DatabaseFixture, Track_findLinks)
+{
+	ScopedTrack track1 {session, "MyTrackFile1"};
+	ScopedTrack track2 {session, "MyTrackFile2"};
+	ScopedRelease release {session, "MyRelease"};
+	ScopedArtist artist1 {session, "MyArtist1"};
+	ScopedArtist artist2 {session, "MyArtist2"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		track1.get().modify()->setRelease(release.get());
+		TrackArtistLink::create(session, track1.get(), artist1.get(), TrackArtistLinkType::Artist);
+		TrackArtistLink::create(session, track1.get(), artist2.get(), TrackArtistLinkType::Composer);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const auto links {Track::findLinks(session, Range {})};
+		ASSERT_EQ(links.results.size(), 3);
+
+		for (const Track::LinksResult& link : links.results)
+		{
+			if (link.trackId == track1.getId())
+			{
+				EXPECT_EQ(link.releaseId, release.getId());
+				if (link.artistId == artist1.getId())
+					EXPECT_EQ(link.linkType, TrackArtistLinkType::Artist);
+				else
+				{
+					EXPECT_EQ(link.artistId, artist2.getId());
+					EXPECT_EQ(link.linkType, TrackArtistLinkType::Composer);
+				}
+			}
+			else
+			{
+				EXPECT_EQ(link.trackId, track2.getId());
+				EXPECT_FALSE(link.releaseId.isValid());
+				EXPECT_FALSE(link.artistId.isValid());
+			}
+		}
+	}
+}
+
+TEST_F(DatabaseFixture, Track_findLinksForTracks)
+{
+	ScopedTrack track1 {session, "MyTrackFile1"};
+	ScopedTrack track2 {session, "MyTrackFile2"};
+	ScopedTrack track3 {session, "MyTrackFile3"};
+	ScopedArtist artist {session, "MyArtist"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		TrackArtistLink::create(session, track1.get(), artist.get(), TrackArtistLinkType::Artist);
+		TrackArtistLink::create(session, track2.get(), artist.get(), TrackArtistLinkType::Artist);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		EXPECT_TRUE(Track::findLinks(session, std::vector<TrackId> {}).empty());
+
+		const auto links {Track::findLinks(session, std::vector<TrackId> {track3.getId(), track2.getId()})};
+		ASSERT_EQ(links.size(), 2);
+		EXPECT_EQ(links[0].trackId, std::min(track2.getId(), track3.getId()));
+		EXPECT_EQ(links[1].trackId, std::max(track2.getId(), track3.getId()));
+
+		for (const Track::LinksResult& link : links)
+		{
+			if (link.trackId == track2.getId())
+				EXPECT_EQ(link.artistId, artist.getId());
+			else
+				EXPECT_FALSE(link.artistId.isValid());
+		}
+	}
+}
+
 TEST_F(DatabaseFixture, MultipleTracks)
 {
 	ScopedTrack track1 {session, "MyTrackFile1"};
@@ -106,6 +239,169 @@ TEST_F(DatabaseFixture, MultipleTracksSearchByFilter)
 	}
 }
 
+TEST_F(DatabaseFixture, MultipleTracksSearchByKeywords)
+{
+	ScopedTrack track1 {session, ""};
+	ScopedTrack track2 {session, ""};
+	ScopedTrack track3 {session, ""};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+		track1.get().modify()->setName("Another song of the year");
+		track2.get().modify()->setName("Song");
+		track3.get().modify()->setName("Église \"Z\"");
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		{
+			const auto tracks {Track::find(session, Track::FindParameters {}.setKeywords({"song"}).setSortMethod(TrackSortMethod::Relevance))};
+			ASSERT_EQ(tracks.results.size(), 2);
+			EXPECT_EQ(tracks.results[0], track2.getId());
+			EXPECT_EQ(tracks.results[1], track1.getId());
+		}
+		{
+			// short keywords
+			const auto tracks {Track::find(session, Track::FindParameters {}.setKeywords({"song", "of"}).setSortMethod(TrackSortMethod::Relevance))};
+			ASSERT_EQ(tracks.results.size(), 1);
+			EXPECT_EQ(tracks.results[0], track1.getId());
+		}
+		{
+			// no full-text match: ordered by id
+			const auto tracks {Track::find(session, Track::FindParameters {}.setKeywords({"so"}).setSortMethod(TrackSortMethod::Relevance))};
+			ASSERT_EQ(tracks.results.size(), 2);
+			EXPECT_EQ(tracks.results[0], std::min(track1.getId(), track2.getId()));
+			EXPECT_EQ(tracks.results[1], std::max(track1.getId(), track2.getId()));
+		}
+		{
+			const auto tracks {Track::find(session, Track::FindParameters {}.setKeywords({"ÉGLISE", "\"z\""}))};
+			ASSERT_EQ(tracks.results.size(), 1);
+			EXPECT_EQ(tracks.results[0], track3.getId());
+		}
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+		track2.get().modify()->setName("Foo");
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const auto tracks {Track::find(session, Track::FindParameters {}.setKeywords({"song"}))};
+		ASSERT_EQ(tracks.results.size(), 1);
+		EXPECT_EQ(tracks.results[0], track1.getId());
+	}
+}
+
+TEST_F(DatabaseFixture, MultipleTracksSearchByKeywordsSameRank)
+{
+	ScopedTrack track1 {session, ""};
+	ScopedTrack track2 {session, ""};
+	ScopedTrack track3 {session, ""};
+	ScopedTrack track4 {session, ""};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+		for (ScopedTrack* track : {&track1, &track2, &track3, &track4})
+			track->get().modify()->setName("Song");
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		// ties are ordered by id, so that pages do not overlap
+		std::vector<TrackId> trackIds;
+		for (std::size_t offset : {0, 2})
+		{
+			const auto tracks {Track::find(session, Track::FindParameters {}.setKeywords({"song"}).setSortMethod(TrackSortMethod::Relevance).setRange({offset, 2}))};
+			ASSERT_EQ(tracks.results.size(), 2);
+			trackIds.insert(std::end(trackIds), std::cbegin(tracks.results), std::cend(tracks.results));
+		}
+
+		const std::vector<TrackId> expectedTrackIds {track1.getId(), track2.getId(), track3.getId(), track4.getId()};
+		EXPECT_EQ(trackIds, expectedTrackIds);
+	}
+}
+
+TEST_F(DatabaseFixture, Track_findRandom)
+{
+	ScopedTrack track1 {session, "MyTrack1"};
+	ScopedTrack track2 {session, "MyTrack2"};
+	ScopedTrack track3 {session, "MyTrack3"};
+	ScopedTrack track4 {session, "MyTrack4"};
+	ScopedClusterType clusterType {session, "MyClusterType"};
+	ScopedCluster cluster {session, clusterType.lockAndGet(), "MyCluster"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		cluster.get().modify()->addTrack(track1.get());
+		cluster.get().modify()->addTrack(track3.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		{
+			const auto tracks {Track::find(session, Track::FindParameters {}.setSortMethod(TrackSortMethod::Random).setRange({0, 3}))};
+			ASSERT_EQ(tracks.results.size(), 3);
+			EXPECT_EQ(std::set<TrackId>(std::cbegin(tracks.results), std::cend(tracks.results)).size(), 3);
+		}
+
+		{
+			const auto tracks {Track::find(session, Track::FindParameters {}.setSortMethod(TrackSortMethod::Random).setClusters({cluster.getId()}).setRange({0, 10}))};
+			ASSERT_EQ(tracks.results.size(), 2);
+			EXPECT_EQ(std::set<TrackId>(std::cbegin(tracks.results), std::cend(tracks.results)), (std::set<TrackId> {track1.getId(), track3.getId()}));
+		}
+	}
+}
+
+TEST_F(DatabaseFixture, Track_findRandomFilteredDistribution)
+{
+	// filtered tracks come in blocks of contiguous ids, like the tracks of an album
+	constexpr std::size_t blockSize {5};
+	constexpr std::size_t blockCount {3};
+	std::list<ScopedTrack> tracks;
+	ScopedClusterType clusterType {session, "MyClusterType"};
+	ScopedCluster cluster {session, clusterType.lockAndGet(), "MyCluster"};
+
+	std::map<TrackId, std::size_t> pickCounts;
+	for (std::size_t i {}; i < blockSize * blockCount * 2; ++i)
+	{
+		tracks.emplace_back(session, "MyTrack" + std::to_string(i));
+		if ((i / blockSize) % 2 == 0)
+		{
+			auto transaction {session.createUniqueTransaction()};
+			cluster.get().modify()->addTrack(tracks.back().get());
+			pickCounts[tracks.back().getId()] = 0;
+		}
+	}
+
+	constexpr std::size_t pickCount {300};
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		for (std::size_t i {}; i < pickCount; ++i)
+		{
+			const auto randomTracks {Track::find(session, Track::FindParameters {}.setSortMethod(TrackSortMethod::Random).setClusters({cluster.getId()}).setRange({0, 1}))};
+			ASSERT_EQ(randomTracks.results.size(), 1);
+
+			auto itPickCount {pickCounts.find(randomTracks.results.front())};
+			ASSERT_NE(itPickCount, std::end(pickCounts));
+			itPickCount->second++;
+		}
+	}
+
+	// each track is expected to be picked 20 times: the first track of each block must not be favored
+	for (const auto& [trackId, count] : pickCounts)
+	{
+		EXPECT_GT(count, 0);
+		EXPECT_LT(count, 3 * pickCount / pickCounts.size());
+	}
+}
+
 TEST_F(DatabaseFixture, Track_date)
 {
 	ScopedTrack track {session, "MyTrack"};
@@ -19,12 +19,53 @@
 
 #include "Common.hpp"
 
+#include <sstream>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
 #include "services/database/TrackFeatures.hpp"
 
 using ScopedTrackFeatures = ScopedEntity<Database::TrackFeatures>;
 
 using namespace Database;
 
+namespace
+{
+	// Each value is the index of the feature
+	std::string
+	createJsonEncodedFeatures()
+	{
+		boost::property_tree::ptree root;
+
+		double value {};
+		for (const FeatureDef& featureDef : TrackFeatures::getFeatureDefs())
+		{
+			if (featureDef.nbDimensions == 1)
+			{
+				root.put(featureDef.name, value);
+			}
+			else
+			{
+				boost::property_tree::ptree array;
+				for (std::size_t i {}; i < featureDef.nbDimensions; ++i)
+				{
+					boost::property_tree::ptree node;
+					node.put("", value);
+					array.push_back(std::make_pair("", node));
+				}
+				root.add_child(featureDef.name, array);
+			}
+
+			value++;
+		}
+
+		std::ostringstream oss;
+		boost::property_tree::write_json(oss, root);
+		return oss.str();
+	}
+}
+
 TEST_F(DatabaseFixture, TrackFeatures)
 {
 	ScopedTrack track {session, "MyTrack"};
@@ -35,7 +76,7 @@ TEST_F(DatabaseFixture, TrackFeatures)
 		EXPECT_EQ(TrackFeatures::getCount(session), 0);
 	}
 
-	ScopedTrackFeatures trackFeatures {session, track.lockAndGet(), ""};
+	ScopedTrackFeatures trackFeatures {session, track.lockAndGet(), TrackFeatures::encodeFeatures(createJsonEncodedFeatures())};
 
 	{
 		auto transaction {session.createUniqueTransaction()};
@@ -44,5 +85,90 @@ TEST_F(DatabaseFixture, TrackFeatures)
 		auto allTrackFeatures {TrackFeatures::find(session, Range {})};
 		ASSERT_EQ(allTrackFeatures.results.size(), 1);
 		EXPECT_EQ(allTrackFeatures.results.front(), trackFeatures.getId());
+
+		auto trackIds {TrackFeatures::findTrackIds(session, Range {})};
+		ASSERT_EQ(trackIds.results.size(), 1);
+		EXPECT_EQ(trackIds.results.front(), track.getId());
 	}
 }
+
+TEST_F(DatabaseFixture, TrackFeatures_values)
+{
+	ScopedTrack track {session, "MyTrack"};
+
+	const std::vector<unsigned char> features {TrackFeatures::encodeFeatures(createJsonEncodedFeatures())};
+	ASSERT_FALSE(features.empty());
+
+	ScopedTrackFeatures trackFeatures {session, track.lockAndGet(), features};
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const FeatureDef& firstFeatureDef {TrackFeatures::getFeatureDefs().front()};
+		const FeatureDef& lastFeatureDef {TrackFeatures::getFeatureDefs().back()};
+
+		const FeatureValuesMap featureValuesMap {trackFeatures.get()->getFeatureValuesMap({firstFeatureDef.name, lastFeatureDef.name})};
+		ASSERT_EQ(featureValuesMap.size(), 2);
+
+		const FeatureValues& firstValues {featureValuesMap.at(firstFeatureDef.name)};
+		ASSERT_EQ(firstValues.size(), firstFeatureDef.nbDimensions);
+		EXPECT_EQ(firstValues.front(), 0);
+
+		const FeatureValues& lastValues {featureValuesMap.at(lastFeatureDef.name)};
+		ASSERT_EQ(lastValues.size(), lastFeatureDef.nbDimensions);
+		EXPECT_EQ(lastValues.front(), static_cast<double>(TrackFeatures::getFeatureDefs().size() - 1));
+
+		EXPECT_TRUE(trackFeatures.get()->getFeatureValuesMap({"unknown.feature"}).empty());
+
+		const auto encodedFeatures {TrackFeatures::findEncodedFeatures(session, TrackFeaturesId {}, 10)};
+		ASSERT_EQ(encodedFeatures.size(), 1);
+		EXPECT_EQ(encodedFeatures.front().id, trackFeatures.getId());
+		EXPECT_EQ(encodedFeatures.front().trackId, track.getId());
+		EXPECT_EQ(TrackFeatures::decodeFeatureValuesMap(encodedFeatures.front().features, {firstFeatureDef.name, lastFeatureDef.name}), featureValuesMap);
+
+		EXPECT_TRUE(TrackFeatures::findEncodedFeatures(session, trackFeatures.getId(), 10).empty());
+	}
+}
+
+TEST_F(DatabaseFixture, TrackFeatures_ids)
+{
+	ScopedTrack track1 {session, "MyTrack1"};
+	ScopedTrack track2 {session, "MyTrack2"};
+
+	const std::vector<unsigned char> features {TrackFeatures::encodeFeatures(createJsonEncodedFeatures())};
+	ASSERT_FALSE(features.empty());
+
+	ScopedTrackFeatures trackFeatures1 {session, track1.lockAndGet(), features};
+	ScopedTrackFeatures trackFeatures2 {session, track2.lockAndGet(), features};
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const auto ids {TrackFeatures::findIds(session, Range {})};
+		ASSERT_EQ(ids.results.size(), 2);
+		for (const TrackFeatures::IdsResult& result : ids.results)
+		{
+			if (result.id == trackFeatures1.getId())
+				EXPECT_EQ(result.trackId, track1.getId());
+			else
+			{
+				EXPECT_EQ(result.id, trackFeatures2.getId());
+				EXPECT_EQ(result.trackId, track2.getId());
+			}
+		}
+
+		EXPECT_TRUE(TrackFeatures::findEncodedFeatures(session, std::vector<TrackFeaturesId> {}).empty());
+
+		const auto encodedFeatures {TrackFeatures::findEncodedFeatures(session, std::vector<TrackFeaturesId> {trackFeatures2.getId()})};
+		ASSERT_EQ(encodedFeatures.size(), 1);
+		EXPECT_EQ(encodedFeatures.front().id, trackFeatures2.getId());
+		EXPECT_EQ(encodedFeatures.front().trackId, track2.getId());
+		EXPECT_EQ(encodedFeatures.front().features, features);
+	}
+}
+
+TEST_F(DatabaseFixture, TrackFeatures_invalidData)
+{
+	EXPECT_TRUE(TrackFeatures::encodeFeatures("").empty());
+	EXPECT_TRUE(TrackFeatures::encodeFeatures("{\"lowlevel\": {}}").empty());
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#include "utils/Logger.hpp"
+
+namespace Recommendation
+{
+	// Read only mapping of a whole file, getData() returns nullptr if the file cannot be mapped
+	class MappedFile
+	{
+		public:
+			MappedFile(const std::filesystem::path& path)
+			{
+				const int fd {::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+				if (fd < 0)
+				{
+					if (errno != ENOENT)
+						LMS_LOG(RECOMMENDATION, ERROR) << "Cannot open '" << path.string() << "': " << ::strerror(errno);
+					return;
+				}
+
+				struct stat fileStat;
+				if (::fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+				{
+					void* data {::mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+					if (data != MAP_FAILED)
+					{
+						_data = static_cast<const std::byte*>(data);
+						_size = fileStat.st_size;
+					}
+					else
+						LMS_LOG(RECOMMENDATION, ERROR) << "Cannot map '" << path.string() << "': " << ::strerror(errno);
+				}
+
+				::close(fd);
+			}
+
+			~MappedFile()
+			{
+				if (_data)
+					::munmap(const_cast<std::byte*>(_data), _size);
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile(MappedFile&&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			MappedFile& operator=(MappedFile&&) = delete;
+
+			const std::byte* getData() const { return _data; }
+			std::size_t getSize() const { return _size; }
+
+		private:
+			const std::byte*	_data {};
+			std::size_t			_size {};
+	};
+
+	// Reads arrays directly from the mapped data
+	class CacheReader
+	{
+		public:
+			CacheReader(const std::byte* begin, const std::byte* end) : _current {begin}, _end {end} {}
+
+			template <typename T>
+			const T* readArray(std::uint64_t count)
+			{
+				if (count > static_cast<std::uint64_t>(_end - _current) / sizeof(T))
+					return nullptr;
+
+				const T* res {reinterpret_cast<const T*>(_current)};
+				_current += count * sizeof(T);
+				return res;
+			}
+
+			bool isAtEnd() const { return _current == _end; }
+
+		private:
+			const std::byte*	_current;
+			const std::byte*	_end;
+	};
+} // namespace Recommendation
+
@@ -19,6 +19,8 @@
 
 #include "RecommendationService.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <unordered_map>
 #include <vector>
 
@@ -55,22 +57,30 @@ namespace Recommendation
 
 	RecommendationService::RecommendationService(Database::Db& db)
 		: _db {db}
+		, _engines {std::make_shared<Engines>()}
 	{
 	}
 
+	std::shared_ptr<const RecommendationService::Engines>
+	RecommendationService::getEngines() const
+	{
+		return std::atomic_load(&_engines);
+	}
+
 	TrackContainer
 	RecommendationService::findSimilarTracks(Database::TrackListId trackListId, std::size_t maxCount) const
 	{
 		TrackContainer res;
 
-		std::shared_lock lock {_enginesMutex};
-		for (const auto& engineType : _enginePriorities)
+		const std::shared_ptr<const Engines> engines {getEngines()};
+		for (const auto& engineType : engines->priorities)
 		{
-			auto itEngine {_engines.find(engineType)};
-			if (itEngine == std::cend(_engines))
+			auto itEngine {engines->engines.find(engineType)};
+			if (itEngine == std::cend(engines->engines))
 				continue;
 
 			res = itEngine->second->findSimilarTracksFromTrackList(trackListId, maxCount);
+			_removedObjects.filter(res);
 			if (!res.empty())
 				break;
 		}
@@ -83,15 +93,16 @@ namespace Recommendation
 	{
 		TrackContainer res;
 
-		std::shared_lock lock {_enginesMutex};
-		for (EngineType engineType : _enginePriorities)
+		const std::shared_ptr<const Engines> engines {getEngines()};
+		for (EngineType engineType : engines->priorities)
 		{
-			auto itEngine {_engines.find(engineType)};
-			if (itEngine == std::cend(_engines))
+			auto itEngine {engines->engines.find(engineType)};
+			if (itEngine == std::cend(engines->engines))
 				continue;
 
 			const IEngine& engine {*itEngine->second};
 			res = engine.findSimilarTracks(trackIds, maxCount);
+			_removedObjects.filter(res);
 			if (!res.empty())
 			{
 				LMS_LOG(RECOMMENDATION, DEBUG) << "Got " << res.size() << " similar tracks using engine '" << engineTypeToString(engineType) << "'";
@@ -107,15 +118,16 @@ namespace Recommendation
 	{
 		ReleaseContainer res;
 
-		std::shared_lock lock {_enginesMutex};
-		for (EngineType engineType : _enginePriorities)
+		const std::shared_ptr<const Engines> engines {getEngines()};
+		for (EngineType engineType : engines->priorities)
 		{
-			auto itEngine {_engines.find(engineType)};
-			if (itEngine == std::cend(_engines))
+			auto itEngine {engines->engines.find(engineType)};
+			if (itEngine == std::cend(engines->engines))
 				continue;
 
 			const IEngine& engine {*itEngine->second};
 			res = engine.getSimilarReleases(releaseId, maxCount);
+			_removedObjects.filter(res);
 			if (!res.empty())
 			{
 				LMS_LOG(RECOMMENDATION, DEBUG) << "Got " << res.size() << " similar releases using engine '" << engineTypeToString(engineType) << "'";
@@ -133,17 +145,18 @@ namespace Recommendation
 	{
 		ArtistContainer res;
 
-		std::shared_lock lock {_enginesMutex};
-		for (EngineType engineType : _enginePriorities)
+		const std::shared_ptr<const Engines> engines {getEngines()};
+		for (EngineType engineType : engines->priorities)
 		{
-			auto itEngine {_engines.find(engineType)};
-			if (itEngine == std::cend(_engines))
+			auto itEngine {engines->engines.find(engineType)};
+			if (itEngine == std::cend(engines->engines))
 				continue;
 
 			LMS_LOG(RECOMMENDATION, DEBUG) << "Trying engine '" << engineTypeToString(engineType) << "'";
 
 			const IEngine& engine {*itEngine->second};
 			res = engine.getSimilarArtists(artistId, linkTypes, maxCount);
+			_removedObjects.filter(res);
 			if (!res.empty())
 			{
 				LMS_LOG(RECOMMENDATION, DEBUG) << "Got " << res.size() << " similar artists using engine '" << engineTypeToString(engineType) << "'";
@@ -154,6 +167,24 @@ namespace Recommendation
 		return res;
 	}
 
+	void
+	RecommendationService::onTracksRemoved(const std::vector<Database::TrackId>& trackIds)
+	{
+		_removedObjects.add(trackIds);
+	}
+
+	void
+	RecommendationService::onReleasesRemoved(const std::vector<Database::ReleaseId>& releaseIds)
+	{
+		_removedObjects.add(releaseIds);
+	}
+
+	void
+	RecommendationService::onArtistsRemoved(const std::vector<Database::ArtistId>& artistIds)
+	{
+		_removedObjects.add(artistIds);
+	}
+
 	static
 	Database::ScanSettings::RecommendationEngineType
 	getRecommendationEngineType(Database::Session& session)
@@ -170,29 +201,26 @@ namespace Recommendation
 
 		LMS_LOG(RECOMMENDATION, INFO) << "Reloading recommendation engines...";
 
-		EngineContainer enginesToLoad;
+		// Current engines are still used until the new ones are loaded
+		std::vector<std::pair<EngineType, std::unique_ptr<IEngine>>> enginesToLoad;
+		std::vector<EngineType> enginePriorities;
 
 		{
 			std::unique_lock controlLock {_controlMutex};
 
-			{
-				std::unique_lock lock {_enginesMutex};
-				_engines.clear();
-			}
-
 			switch (getRecommendationEngineType(_db.getTLSSession()))
 			{
 				case ScanSettings::RecommendationEngineType::Clusters:
-					_enginePriorities = {EngineType::Clusters};
-					enginesToLoad.try_emplace(EngineType::Clusters, createClustersEngine(_db));
+					enginePriorities = {EngineType::Clusters};
+					enginesToLoad.emplace_back(EngineType::Clusters, createClustersEngine(_db));
 					break;
 
 				case ScanSettings::RecommendationEngineType::Features:
-					_enginePriorities = {EngineType::Features, EngineType::Clusters};
+					enginePriorities = {EngineType::Features, EngineType::Clusters};
 
 					// not same order since clusters is faster to load
-					enginesToLoad.try_emplace(EngineType::Clusters, createClustersEngine(_db));
-					enginesToLoad.try_emplace(EngineType::Features, createFeaturesEngine(_db));
+					enginesToLoad.emplace_back(EngineType::Clusters, createClustersEngine(_db));
+					enginesToLoad.emplace_back(EngineType::Features, createFeaturesEngine(_db));
 					break;
 			}
 
@@ -201,16 +229,27 @@ namespace Recommendation
 				_pendingEngines.push_back(engine.get());
 		}
 
+		EngineContainer loadedEngines;
 		for (auto& [engineType, engine] : enginesToLoad)
-			loadPendingEngine(engineType, std::move(engine), forceReload, progressCallback);
+		{
+			if (!loadPendingEngine(engineType, *engine, forceReload, progressCallback))
+				continue;
+
+			loadedEngines.emplace(engineType, std::move(engine));
+			publishEngines(enginePriorities, loadedEngines);
+		}
 
 		_pendingEnginesCondvar.notify_all();
 
+		// Removed objects can no longer be reported once all the engines have been loaded
+		if (loadedEngines.size() == enginesToLoad.size())
+			_removedObjects.clear();
+
 		LMS_LOG(RECOMMENDATION, INFO) << "Recommendation engines loaded!";
 	}
 
-	void
-	RecommendationService::loadPendingEngine(EngineType engineType, std::unique_ptr<IEngine> engine, bool forceReload, const ProgressCallback& progressCallback)
+	bool
+	RecommendationService::loadPendingEngine(EngineType engineType, IEngine& engine, bool forceReload, const ProgressCallback& progressCallback)
 	{
 		if (!_loadCancelled)
 		{
@@ -221,21 +260,48 @@ namespace Recommendation
 				progressCallback(progress);
 			}};
 
-			engine->load(forceReload, progressCallback ? progress : ProgressCallback {});
+			const auto start {std::chrono::steady_clock::now()};
+			engine.load(forceReload, progressCallback ? progress : ProgressCallback {});
+			const auto end {std::chrono::steady_clock::now()};
 
-			LMS_LOG(RECOMMENDATION, INFO) << "Initializing engine '" << engineTypeToString(engineType) << "': " << (_loadCancelled ? "aborted" : "complete");
+			LMS_LOG(RECOMMENDATION, INFO) << "Initializing engine '" << engineTypeToString(engineType) << "': " << (_loadCancelled ? "aborted" : "complete")
+				<< " (" << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms)";
 		}
 
-		{
-			std::scoped_lock lock {_controlMutex};
-			_pendingEngines.erase(std::find(std::begin(_pendingEngines), std::end(_pendingEngines), engine.get()));
-		}
+		std::scoped_lock lock {_controlMutex};
 
-		if (!_loadCancelled)
+		// Must be checked before the engine is no longer pending, as the cancel flag is then reset
+		const bool loaded {!_loadCancelled};
+		_pendingEngines.erase(std::find(std::begin(_pendingEngines), std::end(_pendingEngines), &engine));
+
+		return loaded;
+	}
+
+	void
+	RecommendationService::publishEngines(const std::vector<EngineType>& enginePriorities, const EngineContainer& loadedEngines)
+	{
+		const auto start {std::chrono::steady_clock::now()};
+
+		// Only the loading thread publishes engines
+		const std::shared_ptr<const Engines> currentEngines {getEngines()};
+
+		auto newEngines {std::make_shared<Engines>()};
+		newEngines->priorities = enginePriorities;
+		for (EngineType engineType : enginePriorities)
 		{
-			std::unique_lock lock {_enginesMutex};
-			_engines.emplace(engineType, std::move(engine));
+			// Keep the previous engine until the new one is loaded
+			if (auto itEngine {loadedEngines.find(engineType)}; itEngine != std::cend(loadedEngines))
+				newEngines->engines.emplace(engineType, itEngine->second);
+			else if (auto itEngine {currentEngines->engines.find(engineType)}; itEngine != std::cend(currentEngines->engines))
+				newEngines->engines.emplace(engineType, itEngine->second);
 		}
+
+		std::atomic_store(&_engines, std::shared_ptr<const Engines> {std::move(newEngines)});
+
+		const auto end {std::chrono::steady_clock::now()};
+		LMS_LOG(RECOMMENDATION, DEBUG) << "Published " << loadedEngines.size() << " new engine(s) in " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us";
+
+		// Previous engines are released here, unless they are still being used by some readers
 	}
 
 	void
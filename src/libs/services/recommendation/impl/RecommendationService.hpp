@@ -20,13 +20,14 @@
 #pragma once
 
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
 #include "services/recommendation/IRecommendationService.hpp"
 #include "IEngine.hpp"
+#include "RemovedObjects.hpp"
 
 namespace Database
 {
@@ -61,24 +62,34 @@ namespace Recommendation
 			ReleaseContainer getSimilarReleases(Database::ReleaseId releaseId, std::size_t maxCount) const override;
 			ArtistContainer getSimilarArtists(Database::ArtistId artistId, EnumSet<Database::TrackArtistLinkType> linkTypes, std::size_t maxCount) const override;
 
-			void setEnginePriorities(const std::vector<EngineType>& engineTypes);
-			void clearEngines();
-			void loadPendingEngine(EngineType engineType, std::unique_ptr<IEngine> engine, bool forceReload, const ProgressCallback& progressCallback);
+			void onTracksRemoved(const std::vector<Database::TrackId>& trackIds) override;
+			void onReleasesRemoved(const std::vector<Database::ReleaseId>& releaseIds) override;
+			void onArtistsRemoved(const std::vector<Database::ArtistId>& artistIds) override;
+
+			using EngineContainer = std::unordered_map<EngineType, std::shared_ptr<IEngine>>;
+			struct Engines
+			{
+				std::vector<EngineType>	priorities; // ordered by priority
+				EngineContainer			engines;
+			};
+
+			std::shared_ptr<const Engines> getEngines() const;
+			bool loadPendingEngine(EngineType engineType, IEngine& engine, bool forceReload, const ProgressCallback& progressCallback);
+			void publishEngines(const std::vector<EngineType>& enginePriorities, const EngineContainer& loadedEngines);
 
 			Database::Db&				_db;
 
 			std::mutex					_controlMutex;
 			bool						_loadCancelled {};
 
-			using EngineContainer = std::unordered_map<EngineType, std::unique_ptr<IEngine>>;
-			EngineContainer				_engines;
-			mutable std::shared_mutex	_enginesMutex;
+			// Never modified once published: loaded engines are swapped in as a whole
+			// Readers keep using their own snapshot, even if a more recent one has been published
+			std::shared_ptr<const Engines>	_engines;
 
 			std::vector<IEngine*>		_pendingEngines;
-			std::shared_mutex			_pendingEnginesMutex;
 			std::condition_variable 	_pendingEnginesCondvar;
 
-			std::vector<EngineType>		_enginePriorities; // ordered by priority
+			RemovedObjects				_removedObjects;
 	};
 
 } // ns Recommendation
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "services/database/ArtistId.hpp"
+#include "services/database/ReleaseId.hpp"
+#include "services/database/TrackId.hpp"
+
+namespace Recommendation
+{
+	// Objects removed from the database since the engines have been loaded
+	// Used to filter out stale results without querying the database
+	// Loading the engines (even from their caches) discards the objects that no longer exist
+	class RemovedObjects
+	{
+		public:
+			template <typename IdType>
+			void
+			add(const std::vector<IdType>& ids)
+			{
+				std::unique_lock lock {_mutex};
+				getIds<IdType>().insert(std::cbegin(ids), std::cend(ids));
+			}
+
+			template <typename IdType>
+			void
+			filter(std::vector<IdType>& ids) const
+			{
+				std::shared_lock lock {_mutex};
+
+				const std::unordered_set<IdType>& removedIds {getIds<IdType>()};
+				if (removedIds.empty())
+					return;
+
+				ids.erase(std::remove_if(std::begin(ids), std::end(ids),
+					[&](IdType id)
+					{
+						return removedIds.find(id) != std::cend(removedIds);
+					}), std::end(ids));
+			}
+
+			void
+			clear()
+			{
+				std::unique_lock lock {_mutex};
+				_trackIds.clear();
+				_releaseIds.clear();
+				_artistIds.clear();
+			}
+
+		private:
+			template <typename IdType>
+			std::unordered_set<IdType>&
+			getIds()
+			{
+				return const_cast<std::unordered_set<IdType>&>(static_cast<const RemovedObjects&>(*this).getIds<IdType>());
+			}
+
+			template <typename IdType>
+			const std::unordered_set<IdType>&
+			getIds() const
+			{
+				if constexpr (std::is_same_v<IdType, Database::TrackId>)
+					return _trackIds;
+				else if constexpr (std::is_same_v<IdType, Database::ReleaseId>)
+					return _releaseIds;
+				else
+				{
+					static_assert(std::is_same_v<IdType, Database::ArtistId>);
+					return _artistIds;
+				}
+			}
+
+			mutable std::shared_mutex			_mutex;
+			std::unordered_set<Database::TrackId>	_trackIds;
+			std::unordered_set<Database::ReleaseId>	_releaseIds;
+			std::unordered_set<Database::ArtistId>	_artistIds;
+	};
+} // namespace Recommendation
@@ -19,26 +19,400 @@
 
 #include "ClustersEngine.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "services/database/Artist.hpp"
 #include "services/database/Cluster.hpp"
 #include "services/database/Db.hpp"
 #include "services/database/Release.hpp"
 #include "services/database/Session.hpp"
 #include "services/database/Track.hpp"
+#include "services/database/TrackArtistLink.hpp"
 #include "services/database/TrackList.hpp"
+#include "utils/IConfig.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Random.hpp"
+#include "utils/Service.hpp"
 
 namespace Recommendation {
 
 using namespace Database;
 
+namespace
+{
+	using ObjectIndex = std::uint32_t;
+	using ClusterIndex = std::uint32_t;
+	using Score = std::uint32_t;
+
+	// Maps database ids to contiguous indexes
+	template <typename IdType>
+	class ObjectIndexer
+	{
+		public:
+			ObjectIndex getOrCreateIndex(IdType id)
+			{
+				auto [it, inserted] {_indexes.try_emplace(id, static_cast<ObjectIndex>(_ids.size()))};
+				if (inserted)
+					_ids.push_back(id);
+
+				return it->second;
+			}
+
+			std::optional<ObjectIndex> findIndex(IdType id) const
+			{
+				auto it {_indexes.find(id)};
+				if (it == std::cend(_indexes))
+					return std::nullopt;
+
+				return it->second;
+			}
+
+			IdType getId(ObjectIndex index) const { return _ids[index]; }
+			std::size_t getCount() const { return _ids.size(); }
+
+		private:
+			std::unordered_map<IdType, ObjectIndex>	_indexes;
+			std::vector<IdType>						_ids;
+	};
+
+	using ObjectClusters = std::vector<std::vector<ClusterIndex>>; // distinct clusters of each object
+	using ClusterObjects = std::vector<std::vector<std::pair<ObjectIndex, Score>>>; // weighted objects of each cluster
+
+	template <typename T>
+	void
+	sortAndRemoveDuplicates(std::vector<T>& values)
+	{
+		std::sort(std::begin(values), std::end(values));
+		values.erase(std::unique(std::begin(values), std::end(values)), std::end(values));
+	}
+
+	// The weight of each object is its occurrence count
+	std::vector<std::pair<ObjectIndex, Score>>
+	countObjects(std::vector<ObjectIndex>& objects)
+	{
+		std::sort(std::begin(objects), std::end(objects));
+
+		std::vector<std::pair<ObjectIndex, Score>> res;
+		for (const ObjectIndex object : objects)
+		{
+			if (!res.empty() && res.back().first == object)
+				res.back().second++;
+			else
+				res.emplace_back(object, 1);
+		}
+
+		return res;
+	}
+
+	// Keeps, for each object, the indexSize other objects having the best score
+	// The score of a candidate is the sum of its weights in the clusters of the object, as done by the database queries
+	template <typename IdType>
+	SimilarityIndex<IdType>
+	computeSimilarityIndex(const ObjectIndexer<IdType>& objects, const ObjectClusters& objectClusters, const ClusterObjects& clusterObjects, std::size_t indexSize, const std::atomic<bool>& cancelled)
+	{
+		constexpr std::size_t blockSize {64};
+		const std::size_t objectCount {objects.getCount()};
+
+		std::vector<typename SimilarityIndex<IdType>::Entries> objectEntries(objectCount);
+		std::atomic<std::size_t> nextBlockBegin {};
+
+		auto processBlocks {[&]
+		{
+			std::vector<Score> scores(objectCount);
+			std::vector<ObjectIndex> candidates;
+
+			while (!cancelled)
+			{
+				const std::size_t begin {nextBlockBegin.fetch_add(blockSize)};
+				if (begin >= objectCount)
+					break;
+
+				for (std::size_t object {begin}; object < std::min(begin + blockSize, objectCount); ++object)
+				{
+					for (const ClusterIndex cluster : objectClusters[object])
+					{
+						for (const auto& [candidate, weight] : clusterObjects[cluster])
+						{
+							if (candidate == object)
+								continue;
+
+							if (scores[candidate] == 0)
+								candidates.push_back(candidate);
+							scores[candidate] += weight;
+						}
+					}
+
+					// Candidates having the same score are kept in random order, so that the ones kept at the cut-off are not always the same
+					Random::shuffleContainer(candidates);
+					const std::size_t entryCount {std::min(indexSize, candidates.size())};
+					std::partial_sort(std::begin(candidates), std::begin(candidates) + entryCount, std::end(candidates),
+							[&](ObjectIndex a, ObjectIndex b) { return scores[a] > scores[b]; });
+
+					typename SimilarityIndex<IdType>::Entries& entries {objectEntries[object]};
+					entries.reserve(entryCount);
+					for (std::size_t i {}; i < entryCount; ++i)
+						entries.push_back({objects.getId(candidates[i]), scores[candidates[i]]});
+
+					for (const ObjectIndex candidate : candidates)
+						scores[candidate] = 0;
+					candidates.clear();
+				}
+			}
+		}};
+
+		std::vector<std::thread> threads;
+		for (std::size_t i {1}; i < std::max<std::size_t>(1, std::thread::hardware_concurrency()); ++i)
+			threads.emplace_back(processBlocks);
+
+		processBlocks();
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		SimilarityIndex<IdType> index;
+		for (std::size_t object {}; object < objectCount; ++object)
+		{
+			if (!objectEntries[object].empty())
+				index.setEntries(objects.getId(object), std::move(objectEntries[object]));
+		}
+
+		return index;
+	}
+
+	template <typename IdType>
+	std::vector<IdType>
+	findSimilarObjects(const SimilarityIndex<IdType>& index, const std::vector<IdType>& ids, std::size_t maxCount)
+	{
+		std::vector<const typename SimilarityIndex<IdType>::Entries*> entriesList;
+		for (const IdType id : ids)
+		{
+			if (const auto* entries {index.findEntries(id)})
+				entriesList.push_back(entries);
+		}
+
+		return mergeSimilarityEntries(entriesList, ids, maxCount);
+	}
+}
+
 std::unique_ptr<IEngine> createClustersEngine(Db& db)
 {
 	return std::make_unique<ClusterEngine>(db);
 }
 
+void
+ClusterEngine::load(bool forceReload, const ProgressCallback&)
+{
+	const std::size_t indexSize {Service<IConfig>::get()->getULong("clusters-similarity-index-size", 32)};
+	const std::chrono::minutes minRebuildInterval {Service<IConfig>::get()->getULong("clusters-similarity-index-min-rebuild-interval-minutes", 60)};
+
+	std::optional<ClustersEngineCache> cache {ClustersEngineCache::read()};
+	if (cache && cache->_indexSize == indexSize)
+	{
+		removeStaleObjects(*cache);
+
+		// Building the indexes is expensive and database changes may be frequent (watch mode): outdated indexes are only rebuilt once old enough
+		if (forceReload && !cache->_outdated)
+		{
+			cache->_outdated = true;
+			cache->write();
+		}
+
+		const auto cacheAge {std::chrono::system_clock::now() - cache->_buildTime};
+		if (!cache->_outdated || (cacheAge >= std::chrono::system_clock::duration::zero() && cacheAge < minRebuildInterval))
+		{
+			if (cache->_outdated)
+				LMS_LOG(RECOMMENDATION, INFO) << "Using outdated clusters similarity indexes, built " << std::chrono::duration_cast<std::chrono::minutes>(cacheAge).count() << " minute(s) ago";
+
+			_cache = std::move(cache);
+			return;
+		}
+	}
+
+	ClustersEngineCache::invalidate();
+
+	std::optional<ClustersEngineCache> cache {computeCache(indexSize)};
+	if (!cache || _loadCancelled)
+		return;
+
+	cache->write();
+	_cache = std::move(cache);
+}
+
+void
+ClusterEngine::requestCancelLoad()
+{
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Requesting init cancellation";
+	_loadCancelled = true;
+}
+
+std::optional<ClustersEngineCache>
+ClusterEngine::computeCache(std::size_t indexSize) const
+{
+	LMS_LOG(RECOMMENDATION, INFO) << "Computing clusters similarity indexes...";
+
+	RangeResults<Cluster::TrackLinkResult> clusterLinks;
+	RangeResults<Track::LinksResult> trackLinks;
+	{
+		Session& session {_db.getTLSSession()};
+
+		auto transaction {session.createSharedTransaction()};
+		clusterLinks = Cluster::findTrackLinks(session, Range {});
+		trackLinks = Track::findLinks(session, Range {});
+	}
+
+	constexpr ObjectIndex noRelease {std::numeric_limits<ObjectIndex>::max()};
+
+	ObjectIndexer<TrackId> tracks;
+	ObjectIndexer<ReleaseId> releases;
+	ObjectIndexer<ArtistId> artists;
+	std::vector<ObjectIndex> trackReleases;
+	std::vector<std::vector<std::pair<ObjectIndex, TrackArtistLinkType>>> trackArtists;
+
+	for (const Track::LinksResult& link : trackLinks.results)
+	{
+		const ObjectIndex track {tracks.getOrCreateIndex(link.trackId)};
+		if (track == trackReleases.size())
+		{
+			trackReleases.push_back(link.releaseId.isValid() ? releases.getOrCreateIndex(link.releaseId) : noRelease);
+			trackArtists.emplace_back();
+		}
+
+		if (link.artistId.isValid())
+			trackArtists[track].emplace_back(artists.getOrCreateIndex(link.artistId), link.linkType);
+	}
+
+	ObjectIndexer<ClusterId> clusters;
+	ObjectClusters trackClusters(tracks.getCount());
+	ObjectClusters releaseClusters(releases.getCount());
+	ObjectClusters artistClusters(artists.getCount());
+	std::vector<std::vector<ObjectIndex>> clusterTracks;
+	std::vector<std::vector<ObjectIndex>> clusterReleases;
+	std::unordered_map<TrackArtistLinkType, std::vector<std::vector<ObjectIndex>>> clusterArtistsByLinkType;
+
+	for (const Cluster::TrackLinkResult& link : clusterLinks.results)
+	{
+		const std::optional<ObjectIndex> track {tracks.findIndex(link.trackId)};
+		if (!track)
+			continue;
+
+		const ClusterIndex cluster {clusters.getOrCreateIndex(link.clusterId)};
+		if (cluster == clusterTracks.size())
+		{
+			clusterTracks.emplace_back();
+			clusterReleases.emplace_back();
+		}
+
+		trackClusters[*track].push_back(cluster);
+		clusterTracks[cluster].push_back(*track);
+
+		if (trackReleases[*track] != noRelease)
+		{
+			releaseClusters[trackReleases[*track]].push_back(cluster);
+			clusterReleases[cluster].push_back(trackReleases[*track]);
+		}
+
+		for (const auto& [artist, linkType] : trackArtists[*track])
+		{
+			artistClusters[artist].push_back(cluster);
+
+			std::vector<std::vector<ObjectIndex>>& clusterArtists {clusterArtistsByLinkType[linkType]};
+			clusterArtists.resize(clusters.getCount());
+			clusterArtists[cluster].push_back(artist);
+		}
+	}
+
+	for (ObjectClusters* objectClusters : {&trackClusters, &releaseClusters, &artistClusters})
+	{
+		for (std::vector<ClusterIndex>& clusterIndexes : *objectClusters)
+			sortAndRemoveDuplicates(clusterIndexes);
+	}
+
+	auto toClusterObjects {[&](std::vector<std::vector<ObjectIndex>>& objectsByCluster)
+	{
+		ClusterObjects res(clusters.getCount());
+		for (std::size_t cluster {}; cluster < objectsByCluster.size(); ++cluster)
+			res[cluster] = countObjects(objectsByCluster[cluster]);
+
+		return res;
+	}};
+
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Computing similarity indexes for " << tracks.getCount() << " tracks, " << releases.getCount() << " releases, " << artists.getCount() << " artists and " << clusters.getCount() << " clusters";
+
+	ClustersEngineCache::TrackIndex trackIndex {computeSimilarityIndex(tracks, trackClusters, toClusterObjects(clusterTracks), indexSize, _loadCancelled)};
+	ClustersEngineCache::ReleaseIndex releaseIndex {computeSimilarityIndex(releases, releaseClusters, toClusterObjects(clusterReleases), indexSize, _loadCancelled)};
+	ClustersEngineCache::ArtistIndexes artistIndexes;
+	for (auto& [linkType, clusterArtists] : clusterArtistsByLinkType)
+		artistIndexes.emplace(linkType, computeSimilarityIndex(artists, artistClusters, toClusterObjects(clusterArtists), indexSize, _loadCancelled));
+
+	if (_loadCancelled)
+		return std::nullopt;
+
+	LMS_LOG(RECOMMENDATION, INFO) << "Computing clusters similarity indexes DONE";
+
+	return ClustersEngineCache {indexSize, std::chrono::system_clock::now(), std::move(trackIndex), std::move(releaseIndex), std::move(artistIndexes)};
+}
+
+// Objects may have been removed from the database since the cache was written
+void
+ClusterEngine::removeStaleObjects(ClustersEngineCache& cache) const
+{
+	RangeResults<Track::LinksResult> trackLinks;
+	{
+		Session& session {_db.getTLSSession()};
+
+		auto transaction {session.createSharedTransaction()};
+		trackLinks = Track::findLinks(session, Range {});
+	}
+
+	// Indexed releases and artists are the ones linked to tracks
+	std::unordered_set<TrackId> trackIds;
+	std::unordered_set<ReleaseId> releaseIds;
+	std::unordered_set<ArtistId> artistIds;
+	for (const Track::LinksResult& link : trackLinks.results)
+	{
+		trackIds.insert(link.trackId);
+		if (link.releaseId.isValid())
+			releaseIds.insert(link.releaseId);
+		if (link.artistId.isValid())
+			artistIds.insert(link.artistId);
+	}
+
+	auto isIn {[](const auto& ids) { return [&ids](auto id) { return ids.find(id) != std::cend(ids); }; }};
+
+	std::size_t removedCount {};
+	removedCount += cache._trackIndex.removeInvalidObjects(isIn(trackIds));
+	removedCount += cache._releaseIndex.removeInvalidObjects(isIn(releaseIds));
+	for (auto& [linkType, artistIndex] : cache._artistIndexes)
+		removedCount += artistIndex.removeInvalidObjects(isIn(artistIds));
+
+	if (removedCount > 0)
+		LMS_LOG(RECOMMENDATION, INFO) << "Removed " << removedCount << " stale objects from the cached similarity indexes";
+}
+
+// Objects added since outdated indexes have been built are not indexed
+template <typename IdType>
+bool
+ClusterEngine::canUseIndex(const SimilarityIndex<IdType>& index, const std::vector<IdType>& ids, std::size_t maxCount) const
+{
+	if (maxCount > _cache->_indexSize)
+		return false;
+
+	if (!_cache->_outdated)
+		return true;
+
+	return std::any_of(std::cbegin(ids), std::cend(ids), [&](IdType id) { return index.findEntries(id) != nullptr; });
+}
+
 TrackContainer
 ClusterEngine::findSimilarTracks(const std::vector<TrackId>& trackIds, std::size_t maxCount) const
 {
+	if (_cache && canUseIndex(_cache->_trackIndex, trackIds, maxCount))
+		return findSimilarObjects(_cache->_trackIndex, trackIds, maxCount);
+
 	Session& dbSession {_db.getTLSSession()};
 
 	auto transaction {dbSession.createSharedTransaction()};
@@ -61,6 +435,13 @@ ClusterEngine::findSimilarTracksFromTrackList(TrackListId tracklistId, std::size
 		if (!trackList)
 			return res;
 
+		if (_cache)
+		{
+			const std::vector<TrackId> trackIds {trackList->getTrackIds()};
+			if (canUseIndex(_cache->_trackIndex, trackIds, maxCount))
+				return findSimilarObjects(_cache->_trackIndex, trackIds, maxCount);
+		}
+
 		const auto tracks {trackList->getSimilarTracks(0, maxCount)};
 		res.reserve(tracks.size());
 		std::transform(std::cbegin(tracks), std::cend(tracks), std::back_inserter(res), [](const auto& track) { return track->getId(); });
@@ -72,6 +453,9 @@ ClusterEngine::findSimilarTracksFromTrackList(TrackListId tracklistId, std::size
 ReleaseContainer
 ClusterEngine::getSimilarReleases(ReleaseId releaseId, std::size_t maxCount) const
 {
+	if (_cache && canUseIndex(_cache->_releaseIndex, {releaseId}, maxCount))
+		return findSimilarObjects(_cache->_releaseIndex, {releaseId}, maxCount);
+
 	Session& dbSession {_db.getTLSSession()};
 
 	ReleaseContainer res;
@@ -93,6 +477,24 @@ ClusterEngine::getSimilarReleases(ReleaseId releaseId, std::size_t maxCount) con
 ArtistContainer
 ClusterEngine::getSimilarArtists(ArtistId artistId, EnumSet<TrackArtistLinkType> artistLinkTypes, std::size_t maxCount) const
 {
+	if (_cache && maxCount <= _cache->_indexSize)
+	{
+		// An empty set means all the link types
+		std::vector<const SimilarityIndex<ArtistId>::Entries*> entriesList;
+		for (const auto& [linkType, artistIndex] : _cache->_artistIndexes)
+		{
+			if (!artistLinkTypes.empty() && !artistLinkTypes.contains(linkType))
+				continue;
+
+			if (const auto* entries {artistIndex.findEntries(artistId)})
+				entriesList.push_back(entries);
+		}
+
+		// Artists added since outdated indexes have been built are not indexed
+		if (!entriesList.empty() || !_cache->_outdated)
+			return mergeSimilarityEntries<ArtistId>(entriesList, {artistId}, maxCount);
+	}
+
 	Session& dbSession {_db.getTLSSession()};
 
 	auto transaction {dbSession.createSharedTransaction()};
@@ -19,7 +19,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <optional>
+
 #include "IEngine.hpp"
+#include "ClustersEngineCache.hpp"
 
 namespace Recommendation
 {
@@ -35,15 +39,22 @@ namespace Recommendation
 			ClusterEngine& operator=(ClusterEngine&&) = delete;
 
 		private:
-			void load(bool, const ProgressCallback&) override {}
-			void requestCancelLoad() override {}
+			void load(bool forceReload, const ProgressCallback& progressCallback) override;
+			void requestCancelLoad() override;
 
 			TrackContainer		findSimilarTracksFromTrackList(Database::TrackListId tracklistId, std::size_t maxCount) const override;
 			TrackContainer		findSimilarTracks(const std::vector<Database::TrackId>& tracksId, std::size_t maxCount) const override;
 			ReleaseContainer	getSimilarReleases(Database::ReleaseId releaseId, std::size_t maxCount) const override;
 			ArtistContainer		getSimilarArtists(Database::ArtistId artistId, EnumSet<Database::TrackArtistLinkType> linkTypes, std::size_t maxCount) const override;
 
-			Database::Db& _db;
+			std::optional<ClustersEngineCache> computeCache(std::size_t indexSize) const;
+			void removeStaleObjects(ClustersEngineCache& cache) const;
+			template <typename IdType>
+			bool canUseIndex(const SimilarityIndex<IdType>& index, const std::vector<IdType>& ids, std::size_t maxCount) const;
+
+			Database::Db&		_db;
+			std::atomic<bool>	_loadCancelled {};
+			std::optional<ClustersEngineCache>	_cache; // queries fall back on the database if not set, if too many results are requested or for objects missing from outdated indexes
 	};
 
 } // namespace Recommendation
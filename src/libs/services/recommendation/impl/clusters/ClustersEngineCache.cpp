@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ClustersEngineCache.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include "utils/Crc32Calculator.hpp"
+#include "utils/IConfig.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "CacheFile.hpp"
+
+namespace Recommendation {
+
+namespace
+{
+	// Binary cache layout, values are stored using the host byte order
+	// - CacheHeader
+	// - for each index:
+	//   - CacheIndexHeader
+	//   - objects: objectCount CacheObject
+	//   - entries: entryCount CacheEntry
+	constexpr char cacheMagic[8] {'L', 'M', 'S', 'C', 'L', 'U', 'S', 'T'};
+	constexpr std::uint32_t cacheVersion {2};
+
+	struct CacheHeader
+	{
+		char			magic[8];
+		std::uint32_t	version;
+		std::uint32_t	checksum;	// CRC32 of the data following the header
+		std::uint32_t	indexSize;
+		std::uint32_t	indexCount;
+		std::int64_t	buildTime;	// seconds since epoch
+		std::uint32_t	outdated;
+		std::uint32_t	padding;
+	};
+
+	enum class CacheObjectType : std::uint32_t
+	{
+		Track,
+		Release,
+		Artist,
+	};
+
+	struct CacheIndexHeader
+	{
+		CacheObjectType	objectType;
+		std::uint32_t	linkType;	// only for artists
+		std::uint64_t	objectCount;
+		std::uint64_t	entryCount;
+	};
+
+	struct CacheObject
+	{
+		std::int64_t	id;
+		std::uint32_t	firstEntry;
+		std::uint32_t	entryCount;
+	};
+
+	struct CacheEntry
+	{
+		std::int64_t	id;
+		std::uint32_t	score;
+		std::uint32_t	padding;
+	};
+
+	// Keep all the arrays aligned on their natural alignment
+	static_assert(sizeof(CacheHeader) % alignof(CacheIndexHeader) == 0);
+	static_assert(sizeof(CacheIndexHeader) % alignof(CacheObject) == 0);
+	static_assert(sizeof(CacheObject) % alignof(CacheEntry) == 0);
+	static_assert(sizeof(CacheEntry) % alignof(CacheIndexHeader) == 0);
+
+	template <typename IdType>
+	std::optional<SimilarityIndex<IdType>>
+	readIndex(CacheReader& reader, const CacheIndexHeader& indexHeader)
+	{
+		const CacheObject* objects {reader.readArray<CacheObject>(indexHeader.objectCount)};
+		const CacheEntry* entries {reader.readArray<CacheEntry>(indexHeader.entryCount)};
+		if (!objects || !entries)
+			return std::nullopt;
+
+		SimilarityIndex<IdType> index;
+		for (const CacheObject* object {objects}; object != objects + indexHeader.objectCount; ++object)
+		{
+			if (object->firstEntry > indexHeader.entryCount || object->entryCount > indexHeader.entryCount - object->firstEntry)
+				return std::nullopt;
+
+			typename SimilarityIndex<IdType>::Entries objectEntries;
+			objectEntries.reserve(object->entryCount);
+			for (const CacheEntry* entry {entries + object->firstEntry}; entry != entries + object->firstEntry + object->entryCount; ++entry)
+				objectEntries.push_back({IdType {entry->id}, entry->score});
+
+			index.setEntries(IdType {object->id}, std::move(objectEntries));
+		}
+
+		return index;
+	}
+
+	template <typename IdType, typename WriteArrayFunc>
+	void
+	writeIndex(WriteArrayFunc writeArray, CacheObjectType objectType, std::uint32_t linkType, const SimilarityIndex<IdType>& index)
+	{
+		std::vector<CacheObject> objects;
+		std::vector<CacheEntry> entries;
+		objects.reserve(index.getObjectCount());
+		for (const auto& [id, objectEntries] : index)
+		{
+			objects.push_back({id.getValue(), static_cast<std::uint32_t>(entries.size()), static_cast<std::uint32_t>(objectEntries.size())});
+			for (const auto& entry : objectEntries)
+				entries.push_back({entry.id.getValue(), entry.score, 0});
+		}
+
+		const CacheIndexHeader indexHeader {objectType, linkType, objects.size(), entries.size()};
+		writeArray(&indexHeader, 1);
+		writeArray(objects.data(), objects.size());
+		writeArray(entries.data(), entries.size());
+	}
+}
+
+static
+std::filesystem::path getCacheDirectory()
+{
+	return Service<IConfig>::get()->getPath("working-dir") / "cache" / "clusters";
+}
+
+static std::filesystem::path getCacheFilePath()
+{
+	return getCacheDirectory() / "similarity.bin";
+}
+
+static std::filesystem::path getCacheTmpFilePath()
+{
+	return getCacheDirectory() / "similarity.bin.tmp";
+}
+
+std::optional<ClustersEngineCache>
+ClustersEngineCache::createFromCacheFile(const std::filesystem::path& path)
+{
+	const MappedFile file {path};
+	if (!file.getData())
+		return std::nullopt;
+
+	LMS_LOG(RECOMMENDATION, INFO) << "Reading clusters cache...";
+
+	CacheHeader header;
+	if (file.getSize() < sizeof(header))
+	{
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read clusters cache: file too small";
+		return std::nullopt;
+	}
+	std::memcpy(&header, file.getData(), sizeof(header));
+
+	if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion)
+	{
+		LMS_LOG(RECOMMENDATION, INFO) << "Clusters cache format mismatch, discarding";
+		return std::nullopt;
+	}
+
+	Utils::Crc32Calculator crc;
+	crc.processBytes(file.getData() + sizeof(header), file.getSize() - sizeof(header));
+	if (crc.getResult() != header.checksum)
+	{
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read clusters cache: checksum mismatch";
+		return std::nullopt;
+	}
+
+	TrackIndex trackIndex;
+	ReleaseIndex releaseIndex;
+	ArtistIndexes artistIndexes;
+
+	CacheReader reader {file.getData() + sizeof(header), file.getData() + file.getSize()};
+	for (std::uint32_t i {}; i < header.indexCount; ++i)
+	{
+		const CacheIndexHeader* indexHeader {reader.readArray<CacheIndexHeader>(1)};
+		if (!indexHeader)
+		{
+			LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read clusters cache: bad file size";
+			return std::nullopt;
+		}
+
+		bool success {};
+		switch (indexHeader->objectType)
+		{
+			case CacheObjectType::Track:
+				if (std::optional<TrackIndex> index {readIndex<Database::TrackId>(reader, *indexHeader)})
+				{
+					trackIndex = std::move(*index);
+					success = true;
+				}
+				break;
+
+			case CacheObjectType::Release:
+				if (std::optional<ReleaseIndex> index {readIndex<Database::ReleaseId>(reader, *indexHeader)})
+				{
+					releaseIndex = std::move(*index);
+					success = true;
+				}
+				break;
+
+			case CacheObjectType::Artist:
+				if (std::optional<SimilarityIndex<Database::ArtistId>> index {readIndex<Database::ArtistId>(reader, *indexHeader)})
+				{
+					artistIndexes[static_cast<Database::TrackArtistLinkType>(indexHeader->linkType)] = std::move(*index);
+					success = true;
+				}
+				break;
+		}
+
+		if (!success)
+		{
+			LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read clusters cache: bad index";
+			return std::nullopt;
+		}
+	}
+
+	if (!reader.isAtEnd())
+	{
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read clusters cache: bad file size";
+		return std::nullopt;
+	}
+
+	LMS_LOG(RECOMMENDATION, INFO) << "Successfully read clusters cache";
+
+	ClustersEngineCache cache {header.indexSize, std::chrono::system_clock::time_point {std::chrono::seconds {header.buildTime}}, std::move(trackIndex), std::move(releaseIndex), std::move(artistIndexes)};
+	cache._outdated = header.outdated;
+
+	return cache;
+}
+
+bool
+ClustersEngineCache::toCacheFile(const std::filesystem::path& path) const
+{
+	CacheHeader header {};
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = cacheVersion;
+	header.indexSize = _indexSize;
+	header.indexCount = 2 + _artistIndexes.size();
+	header.buildTime = std::chrono::duration_cast<std::chrono::seconds>(_buildTime.time_since_epoch()).count();
+	header.outdated = _outdated;
+
+	std::ofstream ofs {path, std::ios_base::binary | std::ios_base::trunc};
+	Utils::Crc32Calculator crc;
+	auto writeArray {[&](const auto* data, std::size_t count)
+	{
+		const std::size_t size {count * sizeof(*data)};
+		ofs.write(reinterpret_cast<const char*>(data), size);
+		crc.processBytes(reinterpret_cast<const std::byte*>(data), size);
+	}};
+
+	// Header is rewritten once the checksum is known
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	writeIndex(writeArray, CacheObjectType::Track, 0, _trackIndex);
+	writeIndex(writeArray, CacheObjectType::Release, 0, _releaseIndex);
+	for (const auto& [linkType, artistIndex] : _artistIndexes)
+		writeIndex(writeArray, CacheObjectType::Artist, static_cast<std::uint32_t>(linkType), artistIndex);
+
+	header.checksum = crc.getResult();
+	ofs.seekp(0);
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	ofs.close();
+
+	if (!ofs)
+	{
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot write clusters cache to '" << path.string() << "'";
+		return false;
+	}
+
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Created clusters cache";
+	return true;
+}
+
+void
+ClustersEngineCache::invalidate()
+{
+	std::filesystem::remove(getCacheFilePath());
+}
+
+std::optional<ClustersEngineCache>
+ClustersEngineCache::read()
+{
+	return createFromCacheFile(getCacheFilePath());
+}
+
+void
+ClustersEngineCache::write() const
+{
+	std::filesystem::create_directories(getCacheDirectory());
+
+	// Write to a temporary file first, so that a valid cache file is never partially overwritten
+	if (!toCacheFile(getCacheTmpFilePath()))
+	{
+		std::filesystem::remove(getCacheTmpFilePath());
+		invalidate();
+		return;
+	}
+
+	std::filesystem::rename(getCacheTmpFilePath(), getCacheFilePath());
+}
+
+ClustersEngineCache::ClustersEngineCache(std::size_t indexSize, std::chrono::system_clock::time_point buildTime, TrackIndex trackIndex, ReleaseIndex releaseIndex, ArtistIndexes artistIndexes)
+: _indexSize {indexSize},
+_buildTime {buildTime},
+_trackIndex {std::move(trackIndex)},
+_releaseIndex {std::move(releaseIndex)},
+_artistIndexes {std::move(artistIndexes)}
+{
+}
+
+} // namespace Recommendation
+
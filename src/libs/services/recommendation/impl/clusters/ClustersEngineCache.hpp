@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+
+#include "services/database/ArtistId.hpp"
+#include "services/database/ReleaseId.hpp"
+#include "services/database/TrackId.hpp"
+#include "services/database/Types.hpp"
+#include "SimilarityIndex.hpp"
+
+namespace Recommendation {
+
+// Similarity indexes computed from the clusters shared by the objects
+class ClustersEngineCache
+{
+	public:
+		static void invalidate();
+
+		static std::optional<ClustersEngineCache> read();
+		void write() const;
+
+	private:
+		using TrackIndex = SimilarityIndex<Database::TrackId>;
+		using ReleaseIndex = SimilarityIndex<Database::ReleaseId>;
+		using ArtistIndexes = std::unordered_map<Database::TrackArtistLinkType, SimilarityIndex<Database::ArtistId>>; // scores only use the candidate artists linked using the type
+
+		ClustersEngineCache(std::size_t indexSize, std::chrono::system_clock::time_point buildTime, TrackIndex trackIndex, ReleaseIndex releaseIndex, ArtistIndexes artistIndexes);
+
+		static std::optional<ClustersEngineCache> createFromCacheFile(const std::filesystem::path& path);
+		bool toCacheFile(const std::filesystem::path& path) const;
+
+		friend class ClusterEngine;
+
+		std::size_t		_indexSize; // max entry count for each object
+		std::chrono::system_clock::time_point	_buildTime;
+		bool			_outdated {}; // the database has changed since the indexes have been built
+		TrackIndex		_trackIndex;
+		ReleaseIndex	_releaseIndex;
+		ArtistIndexes	_artistIndexes;
+};
+
+} // namespace Recommendation
+
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/Random.hpp"
+
+namespace Recommendation
+{
+	// Precomputed most similar objects of each object
+	template <typename IdType>
+	class SimilarityIndex
+	{
+		public:
+			using Score = std::uint32_t;
+
+			struct Entry
+			{
+				IdType	id;
+				Score	score;
+			};
+			using Entries = std::vector<Entry>; // sorted by decreasing score
+
+			void			setEntries(IdType id, Entries entries) { _entries[id] = std::move(entries); }
+			const Entries*	findEntries(IdType id) const;
+			std::size_t		getObjectCount() const { return _entries.size(); }
+
+			// Removes the objects for which isValid returns false, from the keys and from the entries
+			// Returns the number of removed keys
+			template <typename IsValidFunc>
+			std::size_t		removeInvalidObjects(IsValidFunc isValid);
+
+			auto begin() const { return std::cbegin(_entries); }
+			auto end() const { return std::cend(_entries); }
+
+		private:
+			std::unordered_map<IdType, Entries>	_entries;
+	};
+
+	template <typename IdType>
+	const typename SimilarityIndex<IdType>::Entries*
+	SimilarityIndex<IdType>::findEntries(IdType id) const
+	{
+		auto it {_entries.find(id)};
+		if (it == std::cend(_entries))
+			return nullptr;
+
+		return &it->second;
+	}
+
+	template <typename IdType>
+	template <typename IsValidFunc>
+	std::size_t
+	SimilarityIndex<IdType>::removeInvalidObjects(IsValidFunc isValid)
+	{
+		std::size_t removedCount {};
+
+		for (auto it {std::begin(_entries)}; it != std::end(_entries);)
+		{
+			if (!isValid(it->first))
+			{
+				it = _entries.erase(it);
+				removedCount++;
+				continue;
+			}
+
+			Entries& entries {it->second};
+			entries.erase(std::remove_if(std::begin(entries), std::end(entries), [&](const Entry& entry) { return !isValid(entry.id); }), std::end(entries));
+			++it;
+		}
+
+		return removedCount;
+	}
+
+	// Sums the scores of the given entries and returns the maxCount best objects, excluding the given ids
+	// Objects having the same score are returned in random order
+	template <typename IdType>
+	std::vector<IdType>
+	mergeSimilarityEntries(const std::vector<const typename SimilarityIndex<IdType>::Entries*>& entriesList, const std::vector<IdType>& excludedIds, std::size_t maxCount)
+	{
+		using Entry = typename SimilarityIndex<IdType>::Entry;
+
+		const std::unordered_set<IdType> excludedIdSet {std::cbegin(excludedIds), std::cend(excludedIds)};
+
+		std::unordered_map<IdType, typename SimilarityIndex<IdType>::Score> scores;
+		for (const auto* entries : entriesList)
+		{
+			for (const Entry& entry : *entries)
+			{
+				if (excludedIdSet.find(entry.id) == std::cend(excludedIdSet))
+					scores[entry.id] += entry.score;
+			}
+		}
+
+		std::vector<Entry> mergedEntries;
+		mergedEntries.reserve(scores.size());
+		for (const auto& [id, score] : scores)
+			mergedEntries.push_back(Entry {id, score});
+
+		Random::shuffleContainer(mergedEntries);
+		std::stable_sort(std::begin(mergedEntries), std::end(mergedEntries), [](const Entry& a, const Entry& b) { return a.score > b.score; });
+
+		std::vector<IdType> res;
+		res.reserve(std::min(maxCount, mergedEntries.size()));
+		for (std::size_t i {}; i < mergedEntries.size() && res.size() < maxCount; ++i)
+			res.push_back(mergedEntries[i].id);
+
+		return res;
+	}
+} // namespace Recommendation
+
@@ -19,19 +19,23 @@
 
 #include "FeaturesEngine.hpp"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <numeric>
+#include <thread>
 
-#include "services/database/Artist.hpp"
 #include "services/database/Db.hpp"
-#include "services/database/Release.hpp"
 #include "services/database/Session.hpp"
 #include "services/database/Track.hpp"
 #include "services/database/TrackArtistLink.hpp"
 #include "services/database/TrackFeatures.hpp"
 #include "services/database/TrackList.hpp"
 #include "som/DataNormalizer.hpp"
+#include "utils/IConfig.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Random.hpp"
+#include "utils/Service.hpp"
 
 
 namespace Recommendation {
@@ -58,14 +62,43 @@ FeaturesEngine::getDefaultTrainFeatureSettings()
 	return defaultTrainFeatureSettings;
 }
 
+// Input vectors are built using this order, so that they can be compared with the ones of a cached network
+static
+std::vector<FeatureName>
+getSortedFeatureNames(const FeatureSettingsMap& featureSettingsMap)
+{
+	std::vector<FeatureName> res;
+	std::transform(std::cbegin(featureSettingsMap), std::cend(featureSettingsMap), std::back_inserter(res),
+		[](const auto& itFeatureSetting) { return itFeatureSetting.first; });
+	std::sort(std::begin(res), std::end(res));
+
+	return res;
+}
+
+static
+std::size_t
+getNbDimensions(const std::vector<FeatureName>& featureNames)
+{
+	return std::accumulate(std::cbegin(featureNames), std::cend(featureNames), std::size_t {0},
+			[](std::size_t sum, const FeatureName& featureName) { return sum + getFeatureDef(featureName).nbDimensions; });
+}
+
 static
 std::optional<SOM::InputVector>
-convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, std::size_t nbDimensions)
+convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, const std::vector<FeatureName>& featureNames, std::size_t nbDimensions)
 {
 	std::size_t i {};
 	std::optional<SOM::InputVector> res {SOM::InputVector {nbDimensions}};
-	for (const auto& [featureName, values] : featureValuesMap)
+	for (const FeatureName& featureName : featureNames)
 	{
+		auto itValues {featureValuesMap.find(featureName)};
+		if (itValues == std::cend(featureValuesMap))
+		{
+			res.reset();
+			break;
+		}
+
+		const FeatureValues& values {itValues->second};
 		if (values.size() != getFeatureDef(featureName).nbDimensions)
 		{
 			LMS_LOG(RECOMMENDATION, WARNING) << "Dimension mismatch for feature '" << featureName << "'. Expected " << getFeatureDef(featureName).nbDimensions << ", got " << values.size();
@@ -80,18 +113,35 @@ convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, s
 	return res;
 }
 
+static
+std::optional<SOM::InputVector>
+getInputVector(const FeatureValuesMap& featureValuesMap, const std::vector<FeatureName>& featureNames, std::size_t nbDimensions)
+{
+	if (featureValuesMap.empty())
+		return std::nullopt;
+
+	return convertFeatureValuesMapToInputVector(featureValuesMap, featureNames, nbDimensions);
+}
+
+static
+std::optional<SOM::InputVector>
+getInputVector(const TrackFeatures::EncodedFeaturesResult& encodedFeatures, const std::vector<FeatureName>& featureNames, std::size_t nbDimensions)
+{
+	return getInputVector(TrackFeatures::decodeFeatureValuesMap(encodedFeatures.features, {std::cbegin(featureNames), std::cend(featureNames)}), featureNames, nbDimensions);
+}
+
 static
 SOM::InputVector
 getInputVectorWeights(const FeatureSettingsMap& featureSettingsMap, std::size_t nbDimensions)
 {
 	SOM::InputVector weights {nbDimensions};
 	std::size_t index {};
-	for (const auto& [featureName, featureSettings] : featureSettingsMap)
+	for (const FeatureName& featureName : getSortedFeatureNames(featureSettingsMap))
 	{
 		const std::size_t featureNbDimensions {getFeatureDef(featureName).nbDimensions};
 
 		for (std::size_t i {}; i < featureNbDimensions; ++i)
-			weights[index++] = (1. / featureNbDimensions * featureSettings.weight);
+			weights[index++] = (1. / featureNbDimensions * featureSettingsMap.at(featureName).weight);
 	}
 
 	assert(index == nbDimensions);
@@ -104,57 +154,16 @@ FeaturesEngine::loadFromTraining(const TrainSettings& trainSettings, const Progr
 {
 	LMS_LOG(RECOMMENDATION, INFO) << "Constructing features classifier...";
 
-	std::unordered_set<FeatureName> featureNames;
-	std::transform(std::cbegin(trainSettings.featureSettingsMap), std::cend(trainSettings.featureSettingsMap), std::inserter(featureNames, std::begin(featureNames)),
-		[](const auto& itFeatureSetting) { return itFeatureSetting.first; });
-
-	const std::size_t nbDimensions {std::accumulate(std::cbegin(featureNames), std::cend(featureNames), std::size_t {0},
-			[](std::size_t sum, const FeatureName& featureName) { return sum + getFeatureDef(featureName).nbDimensions; })};
+	const std::vector<FeatureName> featureNames {getSortedFeatureNames(trainSettings.featureSettingsMap)};
+	const std::size_t nbDimensions {getNbDimensions(featureNames)};
 
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Features dimension = " << nbDimensions;
 
-	Session& session {_db.getTLSSession()};
-
-	RangeResults<TrackFeaturesId> trackFeaturesIds;
-	{
-		auto transaction {session.createSharedTransaction()};
-
-		LMS_LOG(RECOMMENDATION, DEBUG) << "Getting Track features...";
-		trackFeaturesIds = TrackFeatures::find(session, Range {});
-		LMS_LOG(RECOMMENDATION, DEBUG) << "Getting Track features DONE (found " << trackFeaturesIds.results.size() << " track features)";
-	}
-
 	std::vector<SOM::InputVector> samples;
 	std::vector<TrackId> samplesTrackIds;
-
-	samples.reserve(trackFeaturesIds.results.size());
-	samplesTrackIds.reserve(trackFeaturesIds.results.size());
-
-	LMS_LOG(RECOMMENDATION, DEBUG) << "Extracting features...";
-	// TODO handle errors using exceptions
-	for (const TrackFeaturesId trackFeaturesId : trackFeaturesIds.results)
-	{
-		if (_loadCancelled)
-			return;
-
-		auto transaction {session.createSharedTransaction()};
-
-		TrackFeatures::pointer trackFeatures {TrackFeatures::find(session, trackFeaturesId)};
-		if (!trackFeatures)
-			continue;
-
-		FeatureValuesMap featureValuesMap {trackFeatures->getFeatureValuesMap(featureNames)};
-		if (featureValuesMap.empty())
-			continue;
-
-		std::optional<SOM::InputVector> inputVector {convertFeatureValuesMapToInputVector(featureValuesMap, nbDimensions)};
-		if (!inputVector)
-			continue;
-
-		samples.emplace_back(std::move(*inputVector));
-		samplesTrackIds.emplace_back(trackFeatures->getTrack()->getId());
-	}
-	LMS_LOG(RECOMMENDATION, DEBUG) << "Extracting features DONE";
+	std::vector<TrackFeaturesId> samplesFeaturesIds;
+	if (!extractFeatures(featureNames, nbDimensions, trainSettings.threadCount, samples, samplesTrackIds, samplesFeaturesIds))
+		return;
 
 	if (samples.empty())
 	{
@@ -177,7 +186,11 @@ FeaturesEngine::loadFromTraining(const TrainSettings& trainSettings, const Progr
 	}
 	LMS_LOG(RECOMMENDATION, INFO) << "Found " << samples.size() << " tracks, constructing a " << size << "*" << size << " network";
 
-	SOM::Network network {size, size, nbDimensions};
+	SOM::Network network {size, size, nbDimensions, trainSettings.seed};
+	network.setTrainingAlgorithm(trainSettings.algorithm);
+	network.setThreadCount(trainSettings.threadCount);
+	network.setPrecision(trainSettings.precision);
+	network.setNeighbourhoodThreshold(trainSettings.neighbourhoodThreshold);
 
 	SOM::InputVector weights {getInputVectorWeights(trainSettings.featureSettingsMap, nbDimensions)};
 	network.setDataWeights(weights);
@@ -191,12 +204,13 @@ FeaturesEngine::loadFromTraining(const TrainSettings& trainSettings, const Progr
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Training network...";
 	network.train(samples, trainSettings.iterationCount,
 			progressCallback ? somProgressCallback : SOM::Network::ProgressCallback {},
-			[this] { return _loadCancelled; });
+			[this] { return _loadCancelled.load(); });
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Training network DONE";
 
 
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Classifying tracks...";
 	TrackPositions trackPositions;
+	std::unordered_map<TrackId, TrackFeaturesId> trackFeaturesIds;
 	for (std::size_t i {}; i < samples.size(); ++i)
 	{
 		if (_loadCancelled)
@@ -205,11 +219,148 @@ FeaturesEngine::loadFromTraining(const TrainSettings& trainSettings, const Progr
 		const SOM::Position position {network.getClosestRefVectorPosition(samples[i])};
 
 		trackPositions[samplesTrackIds[i]].push_back(position);
+		trackFeaturesIds[samplesTrackIds[i]] = samplesFeaturesIds[i];
 	}
 
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Classifying tracks DONE";
 
-	load(std::move(network), std::move(trackPositions));
+	_trackFeaturesIds = std::move(trackFeaturesIds);
+	_trainedTrackCount = samples.size();
+	load(network, dataNormalizer, trackPositions);
+}
+
+bool
+FeaturesEngine::extractFeatures(const std::vector<FeatureName>& featureNames, std::size_t nbDimensions, std::size_t threadCount, std::vector<SOM::InputVector>& samples, std::vector<TrackId>& samplesTrackIds, std::vector<TrackFeaturesId>& samplesFeaturesIds)
+{
+	constexpr std::size_t batchSize {1000};
+
+	if (threadCount == 0)
+		threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Extracting features using " << threadCount << " thread(s)...";
+
+	// Batches are fetched by this thread and decoded by the workers
+	// Results are stored by batch index, to keep the database order whatever the thread count
+	struct BatchSamples
+	{
+		std::vector<SOM::InputVector> samples;
+		std::vector<TrackId> trackIds;
+		std::vector<TrackFeaturesId> featuresIds;
+	};
+
+	std::mutex mutex;
+	std::condition_variable pendingBatchesCondVar;
+	std::condition_variable processedBatchesCondVar;
+	std::deque<std::pair<std::size_t, std::vector<TrackFeatures::EncodedFeaturesResult>>> pendingBatches;
+	std::vector<BatchSamples> batchesSamples;
+	bool noMoreBatches {};
+
+	auto worker {[&]
+	{
+		while (true)
+		{
+			std::pair<std::size_t, std::vector<TrackFeatures::EncodedFeaturesResult>> batch;
+			{
+				std::unique_lock lock {mutex};
+				pendingBatchesCondVar.wait(lock, [&] { return noMoreBatches || !pendingBatches.empty(); });
+				if (pendingBatches.empty())
+					return;
+
+				batch = std::move(pendingBatches.front());
+				pendingBatches.pop_front();
+			}
+			processedBatchesCondVar.notify_one();
+
+			BatchSamples batchSamples;
+			for (const TrackFeatures::EncodedFeaturesResult& encodedFeatures : batch.second)
+			{
+				if (_loadCancelled)
+					break;
+
+				std::optional<SOM::InputVector> inputVector {getInputVector(encodedFeatures, featureNames, nbDimensions)};
+				if (!inputVector)
+					continue;
+
+				batchSamples.samples.emplace_back(std::move(*inputVector));
+				batchSamples.trackIds.emplace_back(encodedFeatures.trackId);
+				batchSamples.featuresIds.emplace_back(encodedFeatures.id);
+			}
+
+			{
+				std::scoped_lock lock {mutex};
+				batchesSamples[batch.first] = std::move(batchSamples);
+			}
+		}
+	}};
+
+	std::vector<std::thread> threads;
+	for (std::size_t i {}; i < threadCount; ++i)
+		threads.emplace_back(worker);
+
+	auto stopWorkers {[&]
+	{
+		{
+			std::scoped_lock lock {mutex};
+			noMoreBatches = true;
+		}
+		pendingBatchesCondVar.notify_all();
+
+		for (std::thread& thread : threads)
+			thread.join();
+	}};
+
+	Session& session {_db.getTLSSession()};
+
+	TrackFeaturesId lastRetrievedId;
+	for (std::size_t batchIndex {}; !_loadCancelled; ++batchIndex)
+	{
+		std::vector<TrackFeatures::EncodedFeaturesResult> encodedFeatures;
+		try
+		{
+			auto transaction {session.createSharedTransaction()};
+			encodedFeatures = TrackFeatures::findEncodedFeatures(session, lastRetrievedId, batchSize);
+		}
+		catch (...)
+		{
+			stopWorkers();
+			throw;
+		}
+
+		if (encodedFeatures.empty())
+			break;
+
+		lastRetrievedId = encodedFeatures.back().id;
+		const bool lastBatch {encodedFeatures.size() < batchSize};
+
+		{
+			// Limit the memory used by the batches waiting to be decoded
+			std::unique_lock lock {mutex};
+			processedBatchesCondVar.wait(lock, [&] { return pendingBatches.size() < threadCount * 2; });
+
+			batchesSamples.emplace_back();
+			pendingBatches.emplace_back(batchIndex, std::move(encodedFeatures));
+		}
+		pendingBatchesCondVar.notify_one();
+
+		if (lastBatch)
+			break;
+	}
+
+	stopWorkers();
+
+	if (_loadCancelled)
+		return false;
+
+	for (BatchSamples& batchSamples : batchesSamples)
+	{
+		std::move(std::begin(batchSamples.samples), std::end(batchSamples.samples), std::back_inserter(samples));
+		std::move(std::begin(batchSamples.trackIds), std::end(batchSamples.trackIds), std::back_inserter(samplesTrackIds));
+		std::move(std::begin(batchSamples.featuresIds), std::end(batchSamples.featuresIds), std::back_inserter(samplesFeaturesIds));
+	}
+
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Extracting features DONE (" << samples.size() << " samples from " << batchesSamples.size() << " batch(es))";
+
+	return true;
 }
 
 void
@@ -217,7 +368,125 @@ FeaturesEngine::loadFromCache(FeaturesEngineCache&& cache)
 {
 	LMS_LOG(RECOMMENDATION, INFO) << "Constructing features classifier from cache...";
 
-	load(std::move(cache._network), cache._trackPositions);
+	_trackFeaturesIds = std::move(cache._trackFeaturesIds);
+	_trainedTrackCount = cache._trainedTrackCount;
+	// Only the tracks still in the database are loaded: forget about the removed ones
+	load(cache._network, cache._dataNormalizer, cache._trackPositions);
+	for (auto it {std::begin(_trackFeaturesIds)}; it != std::end(_trackFeaturesIds);)
+		it = (_trackPositions.find(it->first) == std::cend(_trackPositions)) ? _trackFeaturesIds.erase(it) : std::next(it);
+}
+
+bool
+FeaturesEngine::loadFromCacheIncrementally(FeaturesEngineCache&& cache, const TrainSettings& trainSettings)
+{
+	const std::vector<FeatureName> featureNames {getSortedFeatureNames(trainSettings.featureSettingsMap)};
+	const std::size_t nbDimensions {getNbDimensions(featureNames)};
+	if (cache._network.getInputDimCount() != nbDimensions)
+	{
+		LMS_LOG(RECOMMENDATION, INFO) << "Features settings changed, training needed";
+		return false;
+	}
+
+	// Features are recreated each time a track is rescanned: tracks whose features differ from the cached ones must be classified again
+	std::unordered_map<TrackId, TrackFeaturesId> trackFeaturesIds;
+	{
+		Session& session {_db.getTLSSession()};
+		auto transaction {session.createSharedTransaction()};
+
+		for (const TrackFeatures::IdsResult& ids : TrackFeatures::findIds(session, Range {}).results)
+			trackFeaturesIds[ids.trackId] = ids.id;
+	}
+
+	// Forget about the changed tracks and the tracks that no longer have features
+	std::size_t removedTrackCount {};
+	for (auto itTrackPositions {std::begin(cache._trackPositions)}; itTrackPositions != std::end(cache._trackPositions);)
+	{
+		const TrackId trackId {itTrackPositions->first};
+		const auto itFeaturesId {trackFeaturesIds.find(trackId)};
+		const auto itCachedFeaturesId {cache._trackFeaturesIds.find(trackId)};
+
+		if (itFeaturesId == std::cend(trackFeaturesIds))
+			removedTrackCount++;
+		else if (itCachedFeaturesId != std::cend(cache._trackFeaturesIds) && itCachedFeaturesId->second == itFeaturesId->second)
+		{
+			++itTrackPositions;
+			continue;
+		}
+
+		cache._trackFeaturesIds.erase(trackId);
+		itTrackPositions = cache._trackPositions.erase(itTrackPositions);
+	}
+
+	std::vector<TrackFeaturesId> featuresIdsToClassify;
+	for (const auto& [trackId, featuresId] : trackFeaturesIds)
+	{
+		if (cache._trackPositions.find(trackId) == std::cend(cache._trackPositions))
+			featuresIdsToClassify.push_back(featuresId);
+	}
+	std::sort(std::begin(featuresIdsToClassify), std::end(featuresIdsToClassify));
+
+	const std::size_t retrainThresholdPercent {Service<IConfig>::get()->getULong("features-retrain-threshold-percent", 10)};
+	// Compare with the number of tracks used for training, so that successive incremental loads cannot drift away from it
+	if ((featuresIdsToClassify.size() + removedTrackCount) * 100 > cache._trainedTrackCount * retrainThresholdPercent)
+	{
+		LMS_LOG(RECOMMENDATION, INFO) << "Found " << featuresIdsToClassify.size() << " new or changed tracks and " << removedTrackCount << " removed tracks for " << cache._trainedTrackCount << " trained tracks, training needed";
+		return false;
+	}
+
+	loadFromCache(std::move(cache));
+	classifyTracks(featuresIdsToClassify, featureNames, nbDimensions);
+
+	return true;
+}
+
+void
+FeaturesEngine::classifyTracks(const std::vector<TrackFeaturesId>& trackFeaturesIds, const std::vector<FeatureName>& featureNames, std::size_t nbDimensions)
+{
+	// Keep the bound parameter count well below the SQLite limit
+	constexpr std::size_t batchSize {500};
+
+	LMS_LOG(RECOMMENDATION, INFO) << "Classifying " << trackFeaturesIds.size() << " new tracks...";
+
+	Session& session {_db.getTLSSession()};
+
+	for (std::size_t batchStart {}; batchStart < trackFeaturesIds.size(); batchStart += batchSize)
+	{
+		if (_loadCancelled)
+			return;
+
+		const std::vector<TrackFeaturesId> batchFeaturesIds(std::next(std::cbegin(trackFeaturesIds), batchStart),
+				std::next(std::cbegin(trackFeaturesIds), std::min(batchStart + batchSize, trackFeaturesIds.size())));
+
+		std::vector<TrackFeatures::EncodedFeaturesResult> encodedFeatures;
+		std::vector<Track::LinksResult> links;
+		{
+			auto transaction {session.createSharedTransaction()};
+
+			encodedFeatures = TrackFeatures::findEncodedFeatures(session, batchFeaturesIds);
+
+			std::vector<TrackId> trackIds;
+			std::transform(std::cbegin(encodedFeatures), std::cend(encodedFeatures), std::back_inserter(trackIds),
+				[](const TrackFeatures::EncodedFeaturesResult& result) { return result.trackId; });
+
+			links = Track::findLinks(session, trackIds);
+		}
+
+		TrackPositions trackPositions;
+		for (const TrackFeatures::EncodedFeaturesResult& result : encodedFeatures)
+		{
+			std::optional<SOM::InputVector> inputVector {getInputVector(result, featureNames, nbDimensions)};
+			if (!inputVector)
+				continue;
+
+			_dataNormalizer->normalizeData(*inputVector);
+			trackPositions[result.trackId].push_back(_network->getClosestRefVectorPosition(*inputVector));
+			_trackFeaturesIds[result.trackId] = result.id;
+		}
+
+		addTracks(links, trackPositions);
+	}
+
+	LMS_LOG(RECOMMENDATION, INFO) << "Classifying new tracks DONE";
 }
 
 TrackContainer
@@ -244,44 +513,14 @@ FeaturesEngine::findSimilarTracksFromTrackList(TrackListId trackListId, std::siz
 TrackContainer
 FeaturesEngine::findSimilarTracks(const std::vector<TrackId>& tracksIds, std::size_t maxCount) const
 {
-	auto similarTrackIds {getSimilarObjects(tracksIds, _trackMatrix, _trackPositions, maxCount)};
-
-	Session& session {_db.getTLSSession()};
-
-	{
-		// Report only existing ids, as tracks may have been removed a long time ago (refreshing the SOM takes some time)
-		auto transaction {session.createSharedTransaction()};
-
-		similarTrackIds.erase(std::remove_if(std::begin(similarTrackIds), std::end(similarTrackIds),
-			[&](TrackId trackId)
-			{
-				return !Track::exists(session, trackId);
-			}), std::end(similarTrackIds));
-	}
-
-	return similarTrackIds;
+	// Removed tracks are filtered out by the recommendation service
+	return getSimilarObjects(tracksIds, _trackMatrix, _trackPositions, maxCount);
 }
 
 ReleaseContainer
 FeaturesEngine::getSimilarReleases(ReleaseId releaseId, std::size_t maxCount) const
 {
-	auto similarReleaseIds {getSimilarObjects({releaseId}, _releaseMatrix, _releasePositions, maxCount)};
-
-	Session& session {_db.getTLSSession()};
-
-	if (!similarReleaseIds.empty())
-	{
-		// Report only existing ids
-		auto transaction {session.createSharedTransaction()};
-
-		similarReleaseIds.erase(std::remove_if(std::begin(similarReleaseIds), std::end(similarReleaseIds),
-			[&](ReleaseId releaseId)
-			{
-				return !Release::exists(session, releaseId);
-			}), std::end(similarReleaseIds));
-	}
-
-	return similarReleaseIds;
+	return getSimilarObjects({releaseId}, _releaseMatrix, _releasePositions, maxCount);
 }
 
 ArtistContainer
@@ -310,18 +549,6 @@ FeaturesEngine::getSimilarArtists(ArtistId artistId, EnumSet<TrackArtistLinkType
 
 	ArtistContainer res(std::cbegin(similarArtistIds), std::cend(similarArtistIds));
 
-	Session& session {_db.getTLSSession()};
-	{
-		// Report only existing ids
-		auto transaction {session.createSharedTransaction()};
-
-		res.erase(std::remove_if(std::begin(res), std::end(res),
-			[&](ArtistId artistId)
-			{
-				return !Artist::exists(session, artistId);
-			}), std::end(res));
-	}
-
 	while (res.size() > maxCount)
 		res.erase(Random::pickRandom(res));
 
@@ -331,25 +558,53 @@ FeaturesEngine::getSimilarArtists(ArtistId artistId, EnumSet<TrackArtistLinkType
 FeaturesEngineCache
 FeaturesEngine::toCache() const
 {
-	return FeaturesEngineCache {*_network, _trackPositions};
+	return FeaturesEngineCache {*_network, *_dataNormalizer, _trackPositions, _trackFeaturesIds, _trainedTrackCount};
+}
+
+static
+SOM::Network::TrainingAlgorithm
+getTrainingAlgorithm()
+{
+	const std::string algorithm {Service<IConfig>::get()->getString("features-training-algorithm", "online")};
+	if (algorithm == "batch")
+		return SOM::Network::TrainingAlgorithm::Batch;
+	if (algorithm != "online")
+		LMS_LOG(RECOMMENDATION, ERROR) << "Unknown training algorithm '" << algorithm << "', using online";
+
+	return SOM::Network::TrainingAlgorithm::Online;
 }
 
 void
 FeaturesEngine::load(bool forceReload, const ProgressCallback& progressCallback)
 {
-	if (forceReload)
+	TrainSettings trainSettings;
+	trainSettings.featureSettingsMap = getDefaultTrainFeatureSettings();
+	trainSettings.algorithm = getTrainingAlgorithm();
+	trainSettings.threadCount = Service<IConfig>::get()->getULong("features-training-thread-count", 0);
+	if (Service<IConfig>::get()->getString("features-training-profile", "default") == "fast")
 	{
-		FeaturesEngineCache::invalidate();
+		trainSettings.precision = SOM::Network::Precision::Float;
+		trainSettings.neighbourhoodThreshold = 0.01;
 	}
-	else if (std::optional<FeaturesEngineCache> cache {FeaturesEngineCache::read()})
+
+	if (std::optional<FeaturesEngineCache> cache {FeaturesEngineCache::read()})
 	{
-		loadFromCache(std::move(*cache));
-		return;
-	}
+		if (!forceReload)
+		{
+			loadFromCache(std::move(*cache));
+			return;
+		}
 
-	TrainSettings trainSettings;
-	trainSettings.featureSettingsMap = getDefaultTrainFeatureSettings();
+		// The database has changed: training is only needed if there are too many new tracks
+		if (loadFromCacheIncrementally(std::move(*cache), trainSettings))
+		{
+			if (!_loadCancelled)
+				toCache().write();
+			return;
+		}
+	}
 
+	FeaturesEngineCache::invalidate();
 	loadFromTraining(trainSettings, progressCallback);
 	if (!_loadCancelled)
 		toCache().write();
@@ -363,10 +618,13 @@ FeaturesEngine::requestCancelLoad()
 }
 
 void
-FeaturesEngine::load(const SOM::Network& network, const TrackPositions& trackPositions)
+FeaturesEngine::load(const SOM::Network& network, const SOM::DataNormalizer& dataNormalizer, const TrackPositions& trackPositions)
 {
 	using namespace Database;
 
+	_network = std::make_unique<SOM::Network>(network);
+	_dataNormalizer = std::make_unique<SOM::DataNormalizer>(dataNormalizer);
+
 	_networkRefVectorsDistanceMedian = network.computeRefVectorsDistanceMedian();
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Median distance betweend ref vectors = " << _networkRefVectorsDistanceMedian;
 
@@ -378,50 +636,97 @@ FeaturesEngine::load(const SOM::Network& network, const TrackPositions& trackPos
 
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Constructing maps...";
 
-	Session& session {_db.getTLSSession()};
+	addTracks(trackPositions);
+	if (_loadCancelled)
+		return;
+
+	LMS_LOG(RECOMMENDATION, INFO) << "Classifier successfully loaded!";
+}
+
+void
+FeaturesEngine::addTracks(const TrackPositions& trackPositions)
+{
+	if (trackPositions.empty())
+		return;
 
-	for (const auto& [trackId, positions] : trackPositions)
+	RangeResults<Track::LinksResult> links;
 	{
-		if (_loadCancelled)
-			return;
+		Session& session {_db.getTLSSession()};
 
 		auto transaction {session.createSharedTransaction()};
+		links = Track::findLinks(session, Range {});
+	}
 
-		const Track::pointer track {Track::find(session, trackId)};
-		if (!track)
-			continue;
+	addTracks(links.results, trackPositions);
+}
+
+void
+FeaturesEngine::addTracks(const std::vector<Track::LinksResult>& links, const TrackPositions& trackPositions)
+{
+	TrackId currentTrackId;
+	const std::vector<SOM::Position>* positions {};
+
+	// Links are ordered by track id
+	for (const Track::LinksResult& link : links)
+	{
+		if (_loadCancelled)
+			return;
 
-		for (const SOM::Position& position : positions)
+		if (link.trackId != currentTrackId)
 		{
-			Utils::push_back_if_not_present(_trackPositions[trackId], position);
-			Utils::push_back_if_not_present(_trackMatrix[position], trackId);
+			currentTrackId = link.trackId;
 
-			if (Release::pointer release {track->getRelease()})
-			{
-				const ReleaseId releaseId {release->getId()};
-				Utils::push_back_if_not_present(_releasePositions[releaseId], position);
-				Utils::push_back_if_not_present(_releaseMatrix[position], releaseId);
-			}
-			for (const TrackArtistLink::pointer& artistLink : track->getArtistLinks())
-			{
-				const ArtistId artistId {artistLink->getArtist()->getId()};
-
-				Utils::push_back_if_not_present(_artistPositions[artistId], position);
-				auto itArtists {_artistMatrix.find(artistLink->getType())};
-				if (itArtists == std::cend(_artistMatrix))
-				{
-					[[maybe_unused]] auto [it, inserted] = _artistMatrix.try_emplace(artistLink->getType(), ArtistMatrix {width, height});
-					assert(inserted);
-					itArtists = it;
-				}
-				Utils::push_back_if_not_present(itArtists->second[position], artistId);
-			}
+			auto itPositions {trackPositions.find(link.trackId)};
+			positions = (itPositions != std::cend(trackPositions)) ? &itPositions->second : nullptr;
+			if (!positions)
+				continue;
+
+			addTrack(link.trackId, *positions);
+			if (link.releaseId.isValid())
+				addRelease(link.releaseId, *positions);
 		}
+
+		if (positions && link.artistId.isValid())
+			addArtist(link.artistId, link.linkType, *positions);
 	}
+}
 
-	_network = std::make_unique<SOM::Network>(network);
+void
+FeaturesEngine::addTrack(TrackId trackId, const std::vector<SOM::Position>& positions)
+{
+	for (const SOM::Position& position : positions)
+	{
+		Utils::push_back_if_not_present(_trackPositions[trackId], position);
+		Utils::push_back_if_not_present(_trackMatrix[position], trackId);
+	}
+}
 
-	LMS_LOG(RECOMMENDATION, INFO) << "Classifier successfully loaded!";
+void
+FeaturesEngine::addRelease(ReleaseId releaseId, const std::vector<SOM::Position>& positions)
+{
+	for (const SOM::Position& position : positions)
+	{
+		Utils::push_back_if_not_present(_releasePositions[releaseId], position);
+		Utils::push_back_if_not_present(_releaseMatrix[position], releaseId);
+	}
+}
+
+void
+FeaturesEngine::addArtist(ArtistId artistId, TrackArtistLinkType linkType, const std::vector<SOM::Position>& positions)
+{
+	auto itArtists {_artistMatrix.find(linkType)};
+	if (itArtists == std::cend(_artistMatrix))
+	{
+		[[maybe_unused]] auto [it, inserted] = _artistMatrix.try_emplace(linkType, ArtistMatrix {_network->getWidth(), _network->getHeight()});
+		assert(inserted);
+		itArtists = it;
+	}
+
+	for (const SOM::Position& position : positions)
+	{
+		Utils::push_back_if_not_present(_artistPositions[artistId], position);
+		Utils::push_back_if_not_present(itArtists->second[position], artistId);
+	}
 }
 
 } // ns Recommendation
@@ -20,12 +20,14 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <unordered_map>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "services/database/Track.hpp"
 #include "som/DataNormalizer.hpp"
 #include "som/Network.hpp"
 #include "utils/Utils.hpp"
@@ -71,8 +73,20 @@ class FeaturesEngine : public IEngine
 			std::size_t iterationCount {10};
 			float sampleCountPerNeuron {4};
 			FeatureSettingsMap featureSettingsMap;
+			SOM::Network::TrainingAlgorithm algorithm {SOM::Network::TrainingAlgorithm::Online};
+			std::size_t threadCount {}; // 0 means auto detect
+			std::optional<std::uint_fast32_t> seed; // set for reproducible results
+			SOM::Network::Precision precision {SOM::Network::Precision::Double};
+			SOM::InputVector::value_type neighbourhoodThreshold {}; // 0 means all the neurons are updated
 		};
 		void loadFromTraining(const TrainSettings& trainSettings, const ProgressCallback& progressCallback);
+		// Decodes the stored features using several threads, returns false if cancelled
+		bool extractFeatures(const std::vector<FeatureName>& featureNames, std::size_t nbDimensions, std::size_t threadCount, std::vector<SOM::InputVector>& samples, std::vector<Database::TrackId>& samplesTrackIds, std::vector<Database::TrackFeaturesId>& samplesFeaturesIds);
+
+		// Only classify the tracks that are missing in the cache or whose features have changed, using the cached network
+		// Returns false if training is needed (too many changes since training or different settings)
+		bool loadFromCacheIncrementally(FeaturesEngineCache&& cache, const TrainSettings& trainSettings);
+		void classifyTracks(const std::vector<Database::TrackFeaturesId>& trackFeaturesIds, const std::vector<FeatureName>& featureNames, std::size_t nbDimensions);
 
 		template <typename IdType>
 		using ObjectPositions = std::unordered_map<IdType, std::vector<SOM::Position>>;
@@ -87,7 +101,13 @@ class FeaturesEngine : public IEngine
 		using ReleaseMatrix = ObjectMatrix<Database::ReleaseId>;
 		using TrackMatrix = ObjectMatrix<Database::TrackId>;
 
-		void load(const SOM::Network& network, const TrackPositions& tracksPosition);
+		void load(const SOM::Network& network, const SOM::DataNormalizer& dataNormalizer, const TrackPositions& tracksPosition);
+		// Fills the matrices using a single bulk query
+		void addTracks(const TrackPositions& trackPositions);
+		void addTracks(const std::vector<Database::Track::LinksResult>& links, const TrackPositions& trackPositions);
+		void addTrack(Database::TrackId trackId, const std::vector<SOM::Position>& positions);
+		void addRelease(Database::ReleaseId releaseId, const std::vector<SOM::Position>& positions);
+		void addArtist(Database::ArtistId artistId, Database::TrackArtistLinkType linkType, const std::vector<SOM::Position>& positions);
 
 		FeaturesEngineCache toCache() const;
 
@@ -104,8 +124,9 @@ class FeaturesEngine : public IEngine
 				std::size_t maxCount) const;
 
 		Database::Db&		_db;
-		bool				_loadCancelled {};
+		std::atomic<bool>	_loadCancelled {};
 		std::unique_ptr<SOM::Network>	_network;
+		std::unique_ptr<SOM::DataNormalizer>	_dataNormalizer; // used to classify new tracks
 		double				_networkRefVectorsDistanceMedian {};
 
 		ArtistPositions     _artistPositions;
@@ -116,6 +137,9 @@ class FeaturesEngine : public IEngine
 
 		TrackPositions		_trackPositions;
 		TrackMatrix			_trackMatrix;
+
+		std::unordered_map<Database::TrackId, Database::TrackFeaturesId>	_trackFeaturesIds; // features used to classify each track
+		std::size_t			_trainedTrackCount {};
 };
 
 template <typename IdType>
@@ -19,15 +19,73 @@
 
 #include "FeaturesEngineCache.hpp"
 
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
 
+#include "utils/Crc32Calculator.hpp"
 #include "utils/IConfig.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Service.hpp"
+#include "CacheFile.hpp"
 
 namespace Recommendation {
 
+namespace
+{
+	// Binary cache layout, values are stored using the host byte order
+	// - CacheHeader
+	// - weights: dimCount values
+	// - normalization factors: dimCount CacheMinMax
+	// - ref vectors: dimCount * width * height values, dimension by dimension
+	// - tracks: trackCount CacheTrack, sorted by id, along with the id of the features used to classify them
+	// - positions: positionCount CachePosition
+	constexpr char cacheMagic[8] {'L', 'M', 'S', 'F', 'E', 'A', 'T', 'S'};
+	constexpr std::uint32_t cacheVersion {3};
+
+	struct CacheHeader
+	{
+		char			magic[8];
+		std::uint32_t	version;
+		std::uint32_t	checksum;	// CRC32 of the data following the header
+		std::uint32_t	width;
+		std::uint32_t	height;
+		std::uint64_t	dimCount;
+		std::uint64_t	trackCount;
+		std::uint64_t	positionCount;
+		std::uint64_t	trainedTrackCount;
+	};
+
+	struct CacheMinMax
+	{
+		double	min;
+		double	max;
+	};
+
+	struct CacheTrack
+	{
+		std::int64_t	id;
+		std::int64_t	featuresId;
+		std::uint32_t	firstPosition;
+		std::uint32_t	positionCount;
+	};
+
+	struct CachePosition
+	{
+		std::uint32_t	x;
+		std::uint32_t	y;
+	};
+
+	using CacheValue = SOM::InputVector::value_type;
+
+	// Keep all the arrays aligned on their natural alignment
+	static_assert(sizeof(CacheHeader) % alignof(CacheValue) == 0);
+	static_assert(sizeof(CacheValue) % alignof(CacheMinMax) == 0);
+	static_assert(sizeof(CacheMinMax) % alignof(CacheValue) == 0);
+	static_assert(sizeof(CacheValue) % alignof(CacheTrack) == 0);
+	static_assert(sizeof(CacheTrack) % alignof(CachePosition) == 0);
+}
 
 static
 std::filesystem::path getCacheDirectory()
@@ -35,220 +93,248 @@ std::filesystem::path getCacheDirectory()
 	return Service<IConfig>::get()->getPath("working-dir") / "cache" / "features";
 }
 
-static std::filesystem::path getCacheNetworkFilePath()
+static std::filesystem::path getCacheFilePath()
 {
-	return getCacheDirectory() / "network";
+	return getCacheDirectory() / "features.bin";
 }
 
-static std::filesystem::path getCacheTrackPositionsFilePath()
+static std::filesystem::path getCacheTmpFilePath()
 {
-	return getCacheDirectory() / "track_positions";
+	return getCacheDirectory() / "features.bin.tmp";
 }
 
-static
-bool
-networkToCacheFile(const SOM::Network& network, std::filesystem::path path)
+// Files from the previous XML based format
+static void removeLegacyCacheFiles()
 {
-	try
-	{
-		boost::property_tree::ptree root;
-
-		root.put("width", network.getWidth());
-		root.put("height", network.getHeight());
-		root.put("dim_count", network.getInputDimCount());
-
-		for (SOM::InputVector::value_type weight : network.getDataWeights())
-			root.add("weights.weight", weight);
-
-		for (SOM::Coordinate x = 0; x < network.getWidth(); ++x)
-		{
-			for (SOM::Coordinate y = 0; y < network.getWidth(); ++y)
-			{
-				const auto& refVector = network.getRefVector({x, y});
-
-				boost::property_tree::ptree node;
-				for (auto value : refVector)
-					node.add("values.value", value);
-
-				node.put("coord_x", x);
-				node.put("coord_y", y);
+	std::error_code ec;
+	std::filesystem::remove(getCacheDirectory() / "network", ec);
+	std::filesystem::remove(getCacheDirectory() / "track_positions", ec);
+}
 
-				root.add_child("ref_vectors.ref_vector", node);
-			}
-		}
+std::optional<FeaturesEngineCache>
+FeaturesEngineCache::createFromCacheFile(const std::filesystem::path& path)
+{
+	const MappedFile file {path};
+	if (!file.getData())
+		return std::nullopt;
 
-		boost::property_tree::write_xml(path.string(), root);
+	LMS_LOG(RECOMMENDATION, INFO) << "Reading features cache...";
 
-		LMS_LOG(RECOMMENDATION, DEBUG) << "Created network cache";
-		return true;
-	}
-	catch (boost::property_tree::ptree_error& error)
+	CacheHeader header;
+	if (file.getSize() < sizeof(header))
 	{
-		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot create network cache: " << error.what();
-		return false;
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read features cache: file too small";
+		return std::nullopt;
 	}
-}
+	std::memcpy(&header, file.getData(), sizeof(header));
 
-std::optional<SOM::Network>
-FeaturesEngineCache::createNetworkFromCacheFile(const std::filesystem::path& path)
-{
-	if (!std::filesystem::exists(path))
+	if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion)
+	{
+		LMS_LOG(RECOMMENDATION, INFO) << "Features cache format mismatch, discarding";
 		return std::nullopt;
+	}
 
-	try
+	CacheReader reader {file.getData() + sizeof(header), file.getData() + file.getSize()};
+	const std::uint64_t refVectorCount {static_cast<std::uint64_t>(header.width) * header.height};
+	const CacheValue* weights {reader.readArray<CacheValue>(header.dimCount)};
+	const CacheMinMax* normalizationFactors {reader.readArray<CacheMinMax>(header.dimCount)};
+	const CacheValue* refVectorValues {header.dimCount == 0 || refVectorCount <= std::numeric_limits<std::uint64_t>::max() / header.dimCount ? reader.readArray<CacheValue>(refVectorCount * header.dimCount) : nullptr};
+	const CacheTrack* tracks {reader.readArray<CacheTrack>(header.trackCount)};
+	const CachePosition* positions {reader.readArray<CachePosition>(header.positionCount)};
+	if (!weights || !normalizationFactors || !refVectorValues || !tracks || !positions || !reader.isAtEnd() || refVectorCount == 0)
 	{
-		LMS_LOG(RECOMMENDATION, INFO) << "Reading network from cache...";
-
-		boost::property_tree::ptree root;
-
-		boost::property_tree::read_xml(path.string(), root);
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read features cache: bad file size";
+		return std::nullopt;
+	}
 
-		SOM::Coordinate width {root.get<SOM::Coordinate>("width")};
-		SOM::Coordinate height {root.get<SOM::Coordinate>("height")};
-		std::size_t dimCount {root.get<std::size_t>("dim_count")};
+	Utils::Crc32Calculator crc;
+	crc.processBytes(file.getData() + sizeof(header), file.getSize() - sizeof(header));
+	if (crc.getResult() != header.checksum)
+	{
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read features cache: checksum mismatch";
+		return std::nullopt;
+	}
 
-		SOM::Network res {width, height, dimCount};
+	const std::size_t dimCount {static_cast<std::size_t>(header.dimCount)};
+	SOM::Network network {header.width, header.height, dimCount};
 
-		{
-			SOM::InputVector weights {dimCount};
-			std::size_t i {};
-			for (const auto& val : root.get_child("weights"))
-				weights[i++] = val.second.get_value<double>();
+	SOM::InputVector values {dimCount};
+	std::copy(weights, weights + dimCount, std::begin(values));
+	network.setDataWeights(values);
 
-			res.setDataWeights(weights);
-		}
+	SOM::DataNormalizer dataNormalizer {dimCount};
+	for (std::size_t dimension {}; dimension < dimCount; ++dimension)
+		dataNormalizer.setValue(dimension, {normalizationFactors[dimension].min, normalizationFactors[dimension].max});
 
-		for (const auto& node : root.get_child("ref_vectors"))
+	for (SOM::Coordinate y {}; y < header.height; ++y)
+	{
+		for (SOM::Coordinate x {}; x < header.width; ++x)
 		{
-			SOM::Coordinate x {node.second.get<SOM::Coordinate>("coord_x")};
-			SOM::Coordinate y {node.second.get<SOM::Coordinate>("coord_y")};
+			const std::size_t index {x + static_cast<std::size_t>(header.width) * y};
+			for (std::size_t dimension {}; dimension < dimCount; ++dimension)
+				values[dimension] = refVectorValues[dimension * refVectorCount + index];
 
-			SOM::InputVector refVector {dimCount};
-			std::size_t i {};
-			for (const auto& val : node.second.get_child("values"))
-				refVector[i++] = val.second.get_value<SOM::InputVector::value_type>();
-
-			res.setRefVector({x, y}, refVector);
+			network.setRefVector({x, y}, values);
 		}
-
-		LMS_LOG(RECOMMENDATION, INFO) << "Successfully read network from cache";
-
-		return res;
-	}
-	catch (boost::property_tree::ptree_error& error)
-	{
-		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read network cache: " << error.what();
-		return std::nullopt;
 	}
-}
 
-bool
-FeaturesEngineCache::objectPositionToCacheFile(const TrackPositions& trackPositions, const std::filesystem::path& path)
-{
-	try
+	TrackPositions trackPositions;
+	TrackFeaturesIds trackFeaturesIds;
+	trackPositions.reserve(header.trackCount);
+	trackFeaturesIds.reserve(header.trackCount);
+	for (const CacheTrack* track {tracks}; track != tracks + header.trackCount; ++track)
 	{
-		boost::property_tree::ptree root;
-
-		for (const auto& [id, positions] : trackPositions)
+		if (track->firstPosition > header.positionCount || track->positionCount > header.positionCount - track->firstPosition)
 		{
-			boost::property_tree::ptree node;
+			LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read features cache: bad track entry";
+			return std::nullopt;
+		}
 
-			node.put("id", id.getValue());
+		trackFeaturesIds[Database::TrackId {track->id}] = Database::TrackFeaturesId {track->featuresId};
 
-			for (const SOM::Position& position : positions)
+		std::vector<SOM::Position>& trackPosition {trackPositions[Database::TrackId {track->id}]};
+		trackPosition.reserve(track->positionCount);
+		for (const CachePosition* position {positions + track->firstPosition}; position != positions + track->firstPosition + track->positionCount; ++position)
+		{
+			if (position->x >= header.width || position->y >= header.height)
 			{
-				boost::property_tree::ptree positionNode;
-				positionNode.put("x", position.x);
-				positionNode.put("y", position.y);
-
-				node.add_child("position.position", positionNode);
+				LMS_LOG(RECOMMENDATION, ERROR) << "Cannot read features cache: bad position";
+				return std::nullopt;
 			}
 
-			root.add_child("objects.object", node);
+			trackPosition.push_back({position->x, position->y});
 		}
-
-		boost::property_tree::write_xml(path.string(), root);
-		return true;
-	}
-	catch (boost::property_tree::ptree_error& error)
-	{
-		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot cache object position: " << error.what();
-		return false;
 	}
-}
-
-std::optional<FeaturesEngineCache::TrackPositions>
-FeaturesEngineCache::createObjectPositionsFromCacheFile(const std::filesystem::path& path)
-{
-	try
-	{
-		LMS_LOG(RECOMMENDATION, INFO) << "Reading object position from cache...";
 
-		boost::property_tree::ptree root;
+	LMS_LOG(RECOMMENDATION, INFO) << "Successfully read features cache";
 
-		boost::property_tree::read_xml(path.string(), root);
+	return FeaturesEngineCache {std::move(network), std::move(dataNormalizer), std::move(trackPositions), std::move(trackFeaturesIds), static_cast<std::size_t>(header.trainedTrackCount)};
+}
 
-		TrackPositions res;
+bool
+FeaturesEngineCache::toCacheFile(const std::filesystem::path& path) const
+{
+	const std::size_t dimCount {_network.getInputDimCount()};
+	const std::size_t refVectorCount {static_cast<std::size_t>(_network.getWidth()) * _network.getHeight()};
 
-		for (const auto& object : root.get_child("objects"))
+	std::vector<CacheValue> refVectorValues(dimCount * refVectorCount);
+	for (SOM::Coordinate y {}; y < _network.getHeight(); ++y)
+	{
+		for (SOM::Coordinate x {}; x < _network.getWidth(); ++x)
 		{
-			const Database::TrackId id {object.second.get<Database::IdType::ValueType>("id")};
-			for (const auto& position : object.second.get_child("position"))
-			{
-				auto x = position.second.get<SOM::Coordinate>("x");
-				auto y = position.second.get<SOM::Coordinate>("y");
-
-				res[id].push_back({x, y});
-			}
+			const std::size_t index {x + static_cast<std::size_t>(_network.getWidth()) * y};
+			const SOM::InputVector refVector {_network.getRefVector({x, y})};
+			for (std::size_t dimension {}; dimension < dimCount; ++dimension)
+				refVectorValues[dimension * refVectorCount + index] = refVector[dimension];
 		}
+	}
 
-		LMS_LOG(RECOMMENDATION, INFO) << "Successfully read object position from cache";
+	std::vector<Database::TrackId> trackIds;
+	trackIds.reserve(_trackPositions.size());
+	for (const auto& [trackId, positions] : _trackPositions)
+		trackIds.push_back(trackId);
+	std::sort(std::begin(trackIds), std::end(trackIds));
+
+	std::vector<CacheTrack> tracks;
+	std::vector<CachePosition> positions;
+	tracks.reserve(trackIds.size());
+	for (const Database::TrackId trackId : trackIds)
+	{
+		const std::vector<SOM::Position>& trackPositions {_trackPositions.at(trackId)};
+		const auto itFeaturesId {_trackFeaturesIds.find(trackId)};
+		const Database::TrackFeaturesId featuresId {itFeaturesId != std::cend(_trackFeaturesIds) ? itFeaturesId->second : Database::TrackFeaturesId {}};
+		tracks.push_back({trackId.getValue(), featuresId.getValue(), static_cast<std::uint32_t>(positions.size()), static_cast<std::uint32_t>(trackPositions.size())});
 
-		return res;
+		for (const SOM::Position& position : trackPositions)
+			positions.push_back({position.x, position.y});
 	}
-	catch (boost::property_tree::ptree_error& error)
+
+	CacheHeader header {};
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = cacheVersion;
+	header.width = _network.getWidth();
+	header.height = _network.getHeight();
+	header.dimCount = dimCount;
+	header.trackCount = tracks.size();
+	header.positionCount = positions.size();
+	header.trainedTrackCount = _trainedTrackCount;
+
+	std::ofstream ofs {path, std::ios_base::binary | std::ios_base::trunc};
+	Utils::Crc32Calculator crc;
+	auto writeArray {[&](const auto* data, std::size_t count)
 	{
-		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot create object position from cache file: " << error.what();
-		return std::nullopt;
+		const std::size_t size {count * sizeof(*data)};
+		ofs.write(reinterpret_cast<const char*>(data), size);
+		crc.processBytes(reinterpret_cast<const std::byte*>(data), size);
+	}};
+
+	// Header is rewritten once the checksum is known
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	const SOM::InputVector& weights {_network.getDataWeights()};
+	const std::vector<CacheValue> weightValues(std::cbegin(weights), std::cend(weights));
+	writeArray(weightValues.data(), weightValues.size());
+
+	std::vector<CacheMinMax> normalizationFactors;
+	normalizationFactors.reserve(dimCount);
+	for (std::size_t dimension {}; dimension < dimCount; ++dimension)
+		normalizationFactors.push_back({_dataNormalizer.getValue(dimension).min, _dataNormalizer.getValue(dimension).max});
+	writeArray(normalizationFactors.data(), normalizationFactors.size());
+	writeArray(refVectorValues.data(), refVectorValues.size());
+	writeArray(tracks.data(), tracks.size());
+	writeArray(positions.data(), positions.size());
+
+	header.checksum = crc.getResult();
+	ofs.seekp(0);
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	ofs.close();
+
+	if (!ofs)
+	{
+		LMS_LOG(RECOMMENDATION, ERROR) << "Cannot write features cache to '" << path.string() << "'";
+		return false;
 	}
+
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Created features cache";
+	return true;
 }
 
 void
 FeaturesEngineCache::invalidate()
 {
-	std::filesystem::remove(getCacheNetworkFilePath());
-	std::filesystem::remove(getCacheTrackPositionsFilePath());
+	std::filesystem::remove(getCacheFilePath());
+	removeLegacyCacheFiles();
 }
 
 std::optional<FeaturesEngineCache>
 FeaturesEngineCache::read()
 {
-	auto network{createNetworkFromCacheFile(getCacheNetworkFilePath())};
-	if (!network)
-		return std::nullopt;
-
-	auto trackPositions{createObjectPositionsFromCacheFile(getCacheTrackPositionsFilePath())};
-	if (!trackPositions)
-		return std::nullopt;
-
-	return FeaturesEngineCache {std::move(*network), std::move(*trackPositions)};
+	return createFromCacheFile(getCacheFilePath());
 }
 
 void
 FeaturesEngineCache::write() const
 {
-	std::filesystem::create_directories(Service<IConfig>::get()->getPath("working-dir") / "cache" / "features");
+	std::filesystem::create_directories(getCacheDirectory());
+	removeLegacyCacheFiles();
 
-	if (!networkToCacheFile(_network, getCacheNetworkFilePath())
-		|| !objectPositionToCacheFile(_trackPositions, getCacheTrackPositionsFilePath()))
+	// Write to a temporary file first, so that a valid cache file is never partially overwritten
+	if (!toCacheFile(getCacheTmpFilePath()))
 	{
+		std::filesystem::remove(getCacheTmpFilePath());
 		invalidate();
+		return;
 	}
+
+	std::filesystem::rename(getCacheTmpFilePath(), getCacheFilePath());
 }
 
-FeaturesEngineCache::FeaturesEngineCache(SOM::Network network, TrackPositions trackPositions)
+FeaturesEngineCache::FeaturesEngineCache(SOM::Network network, SOM::DataNormalizer dataNormalizer, TrackPositions trackPositions, TrackFeaturesIds trackFeaturesIds, std::size_t trainedTrackCount)
 : _network {std::move(network)},
-_trackPositions {std::move(trackPositions)}
+_dataNormalizer {std::move(dataNormalizer)},
+_trackPositions {std::move(trackPositions)},
+_trackFeaturesIds {std::move(trackFeaturesIds)},
+_trainedTrackCount {trainedTrackCount}
 {
 }
 
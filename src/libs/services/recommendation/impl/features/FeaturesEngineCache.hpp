@@ -22,7 +22,9 @@
 #include <filesystem>
 #include <unordered_map>
 
+#include "services/database/TrackFeatures.hpp"
 #include "services/database/TrackId.hpp"
+#include "som/DataNormalizer.hpp"
 #include "som/Network.hpp"
 
 namespace Recommendation {
@@ -37,17 +39,20 @@ class FeaturesEngineCache
 
 	private:
 		using TrackPositions = std::unordered_map<Database::TrackId, std::vector<SOM::Position>>;
+		using TrackFeaturesIds = std::unordered_map<Database::TrackId, Database::TrackFeaturesId>;
 
-		FeaturesEngineCache(SOM::Network network, TrackPositions trackPositions);
+		FeaturesEngineCache(SOM::Network network, SOM::DataNormalizer dataNormalizer, TrackPositions trackPositions, TrackFeaturesIds trackFeaturesIds, std::size_t trainedTrackCount);
 
-		static std::optional<SOM::Network> createNetworkFromCacheFile(const std::filesystem::path& path);
-		static std::optional<TrackPositions> createObjectPositionsFromCacheFile(const std::filesystem::path& path);
-		static bool objectPositionToCacheFile(const TrackPositions& trackPositions, const std::filesystem::path& path);
+		static std::optional<FeaturesEngineCache> createFromCacheFile(const std::filesystem::path& path);
+		bool toCacheFile(const std::filesystem::path& path) const;
 
 		friend class FeaturesEngine;
 
 		SOM::Network		_network;
+		SOM::DataNormalizer	_dataNormalizer;
 		TrackPositions		_trackPositions;
+		TrackFeaturesIds	_trackFeaturesIds; // features used to classify each track
+		std::size_t			_trainedTrackCount {}; // number of tracks used to train the network
 };
 
 } // namespace Recommendation
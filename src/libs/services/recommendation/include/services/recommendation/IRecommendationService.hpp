@@ -20,6 +20,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "utils/EnumSet.hpp"
 #include "services/database/TrackListId.hpp"
 #include "services/database/Types.hpp"
@@ -44,6 +45,11 @@ namespace Recommendation
 			virtual TrackContainer findSimilarTracks(const std::vector<Database::TrackId>& tracksId, std::size_t maxCount) const = 0;
 			virtual ReleaseContainer getSimilarReleases(Database::ReleaseId releaseId, std::size_t maxCount) const = 0;
 			virtual ArtistContainer getSimilarArtists(Database::ArtistId artistId, EnumSet<Database::TrackArtistLinkType> linkTypes, std::size_t maxCount) const = 0;
+
+			// Removed objects are no longer reported, until the next forced reload
+			virtual void onTracksRemoved(const std::vector<Database::TrackId>& trackIds) = 0;
+			virtual void onReleasesRemoved(const std::vector<Database::ReleaseId>& releaseIds) = 0;
+			virtual void onArtistsRemoved(const std::vector<Database::ArtistId>& artistIds) = 0;
 	};
 
 	std::unique_ptr<IRecommendationService> createRecommendationService(Database::Db& db);
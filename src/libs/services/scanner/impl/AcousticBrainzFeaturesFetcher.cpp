@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AcousticBrainzFeaturesFetcher.hpp"
+
+#include <sstream>
+
+#include <boost/asio/post.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "utils/http/IClient.hpp"
+#include "utils/Logger.hpp"
+
+namespace AcousticBrainz
+{
+	namespace
+	{
+		constexpr std::size_t maxRecordingCountPerBulkRequest {25}; // API limit
+		constexpr std::size_t maxResponseSizePerRecording {256 * 1024};
+
+		std::string
+		toJson(const boost::property_tree::ptree& node)
+		{
+			std::ostringstream oss;
+			boost::property_tree::write_json(oss, node, false);
+
+			return oss.str();
+		}
+
+		// Response is like {"mbid1": {"0": {...}}, "mbid2": {"0": {...}}}, missing recordings are omitted
+		std::vector<FeaturesFetcher::Result>
+		parseBulkResponse(std::string_view msgBody, const std::vector<UUID>& recordingMBIDs)
+		{
+			std::vector<FeaturesFetcher::Result> results;
+
+			std::istringstream iss {std::string {msgBody}};
+			boost::property_tree::ptree root;
+			boost::property_tree::read_json(iss, root);
+
+			for (const UUID& recordingMBID : recordingMBIDs)
+			{
+				const auto recordingNode {root.get_child_optional(std::string {recordingMBID.getAsString()})};
+				const auto submissionNode {recordingNode ? recordingNode->get_child_optional("0") : boost::none};
+				if (!submissionNode)
+				{
+					LMS_LOG(DBUPDATER, INFO) << "No low level features available for recording '" << recordingMBID.getAsString() << "'";
+					results.emplace_back(FeaturesFetcher::Result {recordingMBID, {}});
+					continue;
+				}
+
+				results.emplace_back(FeaturesFetcher::Result {recordingMBID, toJson(*submissionNode)});
+			}
+
+			return results;
+		}
+	}
+
+	FeaturesFetcher::FeaturesFetcher(std::string_view baseUrl, std::size_t maxConcurrentRequests)
+	: _ioContextRunner {_ioContext, 1}
+	{
+		LMS_LOG(DBUPDATER, DEBUG) << "Using " << maxConcurrentRequests << " concurrent request(s) to fetch features from '" << baseUrl << "'";
+
+		// AcousticBrainz rate limits apply per IP: all the clients must wait as soon as one of them is rate limited
+		_clients = Http::createClients(_ioContext, baseUrl, maxConcurrentRequests, maxRecordingCountPerBulkRequest * maxResponseSizePerRecording);
+		for (const std::unique_ptr<Http::IClient>& client : _clients)
+			_idleClients.push_back(client.get());
+	}
+
+	FeaturesFetcher::~FeaturesFetcher() = default;
+
+	void
+	FeaturesFetcher::pushRequests(const std::vector<UUID>& recordingMBIDs)
+	{
+		{
+			std::scoped_lock lock {_mutex};
+			_requests.insert(std::end(_requests), std::cbegin(recordingMBIDs), std::cend(recordingMBIDs));
+		}
+
+		sendPendingRequests();
+	}
+
+	std::size_t
+	FeaturesFetcher::getPendingCount() const
+	{
+		std::scoped_lock lock {_mutex};
+		return _requests.size() + _fallbackRequests.size() + _ongoingCount + _results.size();
+	}
+
+	void
+	FeaturesFetcher::waitForResults(std::chrono::milliseconds maxWaitDuration)
+	{
+		std::unique_lock lock {_mutex};
+		_resultsCondVar.wait_for(lock, maxWaitDuration, [this] { return !_results.empty() || (_requests.empty() && _fallbackRequests.empty() && _ongoingCount == 0); });
+	}
+
+	std::vector<FeaturesFetcher::Result>
+	FeaturesFetcher::popResults()
+	{
+		std::vector<Result> results;
+
+		{
+			std::scoped_lock lock {_mutex};
+			results.swap(_results);
+		}
+
+		return results;
+	}
+
+	void
+	FeaturesFetcher::sendPendingRequests()
+	{
+		while (true)
+		{
+			Http::IClient* client {};
+			std::optional<Batch> batch;
+
+			{
+				std::scoped_lock lock {_mutex};
+
+				if (_idleClients.empty())
+					return;
+
+				batch = popNextBatch();
+				if (!batch)
+					return;
+
+				client = _idleClients.back();
+				_idleClients.pop_back();
+				_ongoingCount += batch->recordingMBIDs.size();
+			}
+
+			// Must not be called with the lock held: the callbacks may be called synchronously
+			sendBatch(*client, *batch);
+		}
+	}
+
+	std::optional<FeaturesFetcher::Batch>
+	FeaturesFetcher::popNextBatch()
+	{
+		std::optional<Batch> batch;
+
+		if (!_fallbackRequests.empty())
+		{
+			batch = Batch {{std::move(_fallbackRequests.front())}, false};
+			_fallbackRequests.pop_front();
+		}
+		else if (!_requests.empty())
+		{
+			batch = Batch {{}, true};
+			while (!_requests.empty() && batch->recordingMBIDs.size() < maxRecordingCountPerBulkRequest)
+			{
+				batch->recordingMBIDs.push_back(std::move(_requests.front()));
+				_requests.pop_front();
+			}
+		}
+
+		return batch;
+	}
+
+	void
+	FeaturesFetcher::sendBatch(Http::IClient& client, const Batch& batch)
+	{
+		if (batch.bulk)
+			sendBulkRequest(client, batch.recordingMBIDs);
+		else
+			sendSingleRequest(client, batch.recordingMBIDs.front());
+	}
+
+	void
+	FeaturesFetcher::sendBulkRequest(Http::IClient& client, const std::vector<UUID>& recordingMBIDs)
+	{
+		LMS_LOG(DBUPDATER, DEBUG) << "Fetching low level features for " << recordingMBIDs.size() << " recording(s)";
+
+		Http::ClientGETRequestParameters request;
+		request.relativeUrl = "/api/v1/low-level?recording_ids=";
+		for (std::size_t i {}; i < recordingMBIDs.size(); ++i)
+		{
+			if (i != 0)
+				request.relativeUrl += ';';
+			request.relativeUrl += recordingMBIDs[i].getAsString();
+		}
+
+		request.onSuccessFunc = [this, &client, recordingMBIDs](std::string_view msgBody)
+		{
+			try
+			{
+				onRequestDone(client, recordingMBIDs.size(), parseBulkResponse(msgBody, recordingMBIDs), {});
+			}
+			catch (boost::property_tree::ptree_error& error)
+			{
+				LMS_LOG(DBUPDATER, ERROR) << "Cannot parse bulk low level features response: " << error.what() << ", falling back to single requests";
+				onRequestDone(client, recordingMBIDs.size(), {}, recordingMBIDs);
+			}
+		};
+		request.onFailureFunc = [this, &client, recordingMBIDs]
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot fetch low level features for " << recordingMBIDs.size() << " recording(s), falling back to single requests";
+			onRequestDone(client, recordingMBIDs.size(), {}, recordingMBIDs);
+		};
+
+		client.sendGETRequest(std::move(request));
+	}
+
+	void
+	FeaturesFetcher::sendSingleRequest(Http::IClient& client, const UUID& recordingMBID)
+	{
+		LMS_LOG(DBUPDATER, DEBUG) << "Fetching low level features for recording '" << recordingMBID.getAsString() << "'";
+
+		Http::ClientGETRequestParameters request;
+		request.relativeUrl = "/api/v1/" + std::string {recordingMBID.getAsString()} + "/low-level";
+		request.onSuccessFunc = [this, &client, recordingMBID](std::string_view msgBody)
+		{
+			onRequestDone(client, 1, {Result {recordingMBID, std::string {msgBody}}}, {});
+		};
+		request.onFailureFunc = [this, &client, recordingMBID]
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot fetch low level features for recording '" << recordingMBID.getAsString() << "'";
+			onRequestDone(client, 1, {Result {recordingMBID, {}}}, {});
+		};
+
+		client.sendGETRequest(std::move(request));
+	}
+
+	void
+	FeaturesFetcher::onRequestDone(Http::IClient& client, std::size_t recordingCount, std::vector<Result> results, std::vector<UUID> fallbackRecordingMBIDs)
+	{
+		{
+			std::scoped_lock lock {_mutex};
+
+			_results.insert(std::end(_results), std::make_move_iterator(std::begin(results)), std::make_move_iterator(std::end(results)));
+			_fallbackRequests.insert(std::end(_fallbackRequests), std::make_move_iterator(std::begin(fallbackRecordingMBIDs)), std::make_move_iterator(std::end(fallbackRecordingMBIDs)));
+			_ongoingCount -= recordingCount;
+			_idleClients.push_back(&client);
+		}
+		_resultsCondVar.notify_all();
+
+		// Posted in order not to recurse if requests fail synchronously
+		boost::asio::post(_ioContext, [this] { sendPendingRequests(); });
+	}
+} // namespace AcousticBrainz
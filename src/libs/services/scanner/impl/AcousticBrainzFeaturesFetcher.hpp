@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+
+#include "utils/IOContextRunner.hpp"
+#include "utils/UUID.hpp"
+
+namespace Http
+{
+	class IClient;
+}
+
+namespace AcousticBrainz
+{
+	// Fetches the low level features of recordings using a bounded number of concurrent requests
+	// Each request slot has its own persistent client, rate limits are handled by the clients and shared among them
+	// Recordings are grouped in bulk requests, falling back to one request per recording on error
+	class FeaturesFetcher
+	{
+		public:
+			FeaturesFetcher(std::string_view baseUrl, std::size_t maxConcurrentRequests);
+			~FeaturesFetcher();
+
+			FeaturesFetcher(const FeaturesFetcher&) = delete;
+			FeaturesFetcher(FeaturesFetcher&&) = delete;
+			FeaturesFetcher& operator=(const FeaturesFetcher&) = delete;
+			FeaturesFetcher& operator=(FeaturesFetcher&&) = delete;
+
+			struct Result
+			{
+				UUID		recordingMBID;
+				std::string	data; // empty on failure
+			};
+
+			void				pushRequests(const std::vector<UUID>& recordingMBIDs);
+			std::size_t			getPendingCount() const; // includes the results that have not been popped yet
+			void				waitForResults(std::chrono::milliseconds maxWaitDuration);
+			std::vector<Result>	popResults();
+
+		private:
+			struct Batch
+			{
+				std::vector<UUID>	recordingMBIDs;
+				bool				bulk;
+			};
+
+			void					sendPendingRequests();
+			std::optional<Batch>	popNextBatch();
+			void					sendBatch(Http::IClient& client, const Batch& batch);
+			void					sendBulkRequest(Http::IClient& client, const std::vector<UUID>& recordingMBIDs);
+			void					sendSingleRequest(Http::IClient& client, const UUID& recordingMBID);
+			void					onRequestDone(Http::IClient& client, std::size_t recordingCount, std::vector<Result> results, std::vector<UUID> fallbackRecordingMBIDs);
+
+			boost::asio::io_context						_ioContext;
+			std::vector<std::unique_ptr<Http::IClient>>	_clients;
+
+			mutable std::mutex			_mutex;
+			std::condition_variable		_resultsCondVar;
+			std::vector<Http::IClient*>	_idleClients;
+			std::deque<UUID>			_requests;
+			std::deque<UUID>			_fallbackRequests; // to be sent one by one
+			std::size_t					_ongoingCount {}; // in recordings
+			std::vector<Result>			_results;
+
+			// Must be the last member: stopped first on destruction
+			IOContextRunner				_ioContextRunner;
+	};
+} // namespace AcousticBrainz
+
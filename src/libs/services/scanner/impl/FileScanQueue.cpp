@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileScanQueue.hpp"
+
+#include "utils/Logger.hpp"
+
+namespace Scanner
+{
+	FileScanQueue::FileScanQueue(std::size_t threadCount, MetaData::ParserReadStyle readStyle, const std::set<std::string>& clusterTypeNames, const std::atomic<bool>& abort)
+	: _abort {abort}
+	{
+		LMS_LOG(DBUPDATER, DEBUG) << "Using " << threadCount << " thread(s) to parse files";
+
+		for (std::size_t i {}; i < threadCount; ++i)
+			_threads.emplace_back([=] { worker(readStyle, clusterTypeNames); });
+	}
+
+	FileScanQueue::~FileScanQueue()
+	{
+		{
+			std::scoped_lock lock {_mutex};
+			_stop = true;
+		}
+		_requestsCondVar.notify_all();
+
+		for (std::thread& thread : _threads)
+			thread.join();
+	}
+
+	void
+	FileScanQueue::pushScanRequest(ScanRequest&& request)
+	{
+		{
+			std::scoped_lock lock {_mutex};
+			_requests.emplace_back(std::move(request));
+		}
+		_requestsCondVar.notify_one();
+	}
+
+	std::size_t
+	FileScanQueue::getPendingCount() const
+	{
+		std::scoped_lock lock {_mutex};
+		return _requests.size() + _ongoingCount + _results.size();
+	}
+
+	void
+	FileScanQueue::waitForResults(std::chrono::milliseconds maxWaitDuration)
+	{
+		std::unique_lock lock {_mutex};
+		_resultsCondVar.wait_for(lock, maxWaitDuration, [this] { return !_results.empty() || (_requests.empty() && _ongoingCount == 0); });
+	}
+
+	std::vector<FileScanQueue::ScanResult>
+	FileScanQueue::popResults()
+	{
+		std::vector<ScanResult> results;
+
+		{
+			std::scoped_lock lock {_mutex};
+			results.swap(_results);
+		}
+
+		return results;
+	}
+
+	void
+	FileScanQueue::worker(MetaData::ParserReadStyle readStyle, const std::set<std::string>& clusterTypeNames)
+	{
+		// For now, always use TagLib
+		std::unique_ptr<MetaData::IParser> parser {MetaData::createParser(MetaData::ParserType::TagLib, readStyle)};
+		parser->setClusterTypeNames(clusterTypeNames);
+
+		while (true)
+		{
+			ScanRequest request;
+
+			{
+				std::unique_lock lock {_mutex};
+				_requestsCondVar.wait(lock, [this] { return _stop || !_requests.empty(); });
+				if (_stop)
+					return;
+
+				request = std::move(_requests.front());
+				_requests.pop_front();
+				_ongoingCount++;
+			}
+
+			ScanResult result {std::move(request.path), request.lastWriteTime, std::nullopt};
+
+			// Still report a result on abort, so that the pending count remains accurate
+			if (!_abort)
+				result.trackInfo = parser->parse(result.path);
+
+			{
+				std::scoped_lock lock {_mutex};
+				_ongoingCount--;
+				_results.emplace_back(std::move(result));
+			}
+			_resultsCondVar.notify_all();
+		}
+	}
+} // namespace Scanner
+
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Wt/WDateTime.h>
+
+#include "metadata/IParser.hpp"
+
+namespace Scanner
+{
+	// Parses audio files using a pool of worker threads
+	// Each worker owns its own parser, results are to be consumed by a single thread
+	class FileScanQueue
+	{
+		public:
+			struct ScanRequest
+			{
+				std::filesystem::path	path;
+				Wt::WDateTime			lastWriteTime;
+			};
+
+			struct ScanResult
+			{
+				std::filesystem::path			path;
+				Wt::WDateTime					lastWriteTime;
+				std::optional<MetaData::Track>	trackInfo; // empty on parse error
+			};
+
+			FileScanQueue(std::size_t threadCount, MetaData::ParserReadStyle readStyle, const std::set<std::string>& clusterTypeNames, const std::atomic<bool>& abort);
+			~FileScanQueue();
+
+			FileScanQueue(const FileScanQueue&) = delete;
+			FileScanQueue(FileScanQueue&&) = delete;
+			FileScanQueue& operator=(const FileScanQueue&) = delete;
+			FileScanQueue& operator=(FileScanQueue&&) = delete;
+
+			void pushScanRequest(ScanRequest&& request);
+
+			// Number of requests that have been pushed but whose results have not been popped yet
+			std::size_t getPendingCount() const;
+
+			// Blocks until at least one result is available, nothing is pending anymore or maxWaitDuration has elapsed
+			void waitForResults(std::chrono::milliseconds maxWaitDuration);
+			std::vector<ScanResult> popResults();
+
+		private:
+			void worker(MetaData::ParserReadStyle readStyle, const std::set<std::string>& clusterTypeNames);
+
+			const std::atomic<bool>&	_abort;
+
+			mutable std::mutex			_mutex;
+			std::condition_variable		_requestsCondVar;
+			std::condition_variable		_resultsCondVar;
+			bool						_stop {};
+			std::deque<ScanRequest>		_requests;
+			std::size_t					_ongoingCount {};
+			std::vector<ScanResult>		_results;
+
+			std::vector<std::thread>	_threads;
+	};
+} // namespace Scanner
+
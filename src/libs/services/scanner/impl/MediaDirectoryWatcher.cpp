@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MediaDirectoryWatcher.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include "utils/Exception.hpp"
+#include "utils/Logger.hpp"
+
+namespace Scanner
+{
+	namespace
+	{
+		constexpr std::uint32_t watchMask {IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_ONLYDIR};
+	}
+
+	MediaDirectoryWatcher::MediaDirectoryWatcher(const std::filesystem::path& rootDirectory, const std::filesystem::path& excludeDirFileName, ChangeCallback callback)
+	: _rootDirectory {rootDirectory}
+	, _excludeDirFileName {excludeDirFileName}
+	, _callback {std::move(callback)}
+	{
+		_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (_inotifyFd < 0)
+			throw LmsException {"Cannot init inotify: " + std::string {::strerror(errno)}};
+
+		_stopFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (_stopFd < 0)
+		{
+			::close(_inotifyFd);
+			throw LmsException {"Cannot create eventfd: " + std::string {::strerror(errno)}};
+		}
+
+		_thread = std::thread {[this] { run(); }};
+	}
+
+	MediaDirectoryWatcher::~MediaDirectoryWatcher()
+	{
+		const std::uint64_t value {1};
+		if (::write(_stopFd, &value, sizeof(value)) != sizeof(value))
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot notify watcher thread: " << ::strerror(errno);
+
+		_thread.join();
+
+		::close(_stopFd);
+		::close(_inotifyFd);
+	}
+
+	void
+	MediaDirectoryWatcher::run()
+	{
+		LMS_LOG(DBUPDATER, INFO) << "Watching media directory '" << _rootDirectory.string() << "'...";
+		addWatchRecursive(_rootDirectory);
+		LMS_LOG(DBUPDATER, INFO) << "Watching " << _watchedDirectories.size() << " directories";
+
+		while (true)
+		{
+			std::array<pollfd, 2> fds {{{_inotifyFd, POLLIN, 0}, {_stopFd, POLLIN, 0}}};
+
+			if (::poll(fds.data(), fds.size(), -1) < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				LMS_LOG(DBUPDATER, ERROR) << "Poll failed: " << ::strerror(errno) << ", stop watching media directory";
+				return;
+			}
+
+			if (fds[1].revents & POLLIN)
+				return;
+
+			if (fds[0].revents & POLLIN)
+				processEvents();
+		}
+	}
+
+	void
+	MediaDirectoryWatcher::addWatchRecursive(const std::filesystem::path& directory)
+	{
+		const int wd {::inotify_add_watch(_inotifyFd, directory.c_str(), watchMask)};
+		if (wd < 0)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot watch directory '" << directory.string() << "': " << ::strerror(errno) << (errno == ENOSPC ? " (consider raising fs.inotify.max_user_watches)" : "");
+			return;
+		}
+		_watchedDirectories[wd] = directory;
+
+		// Excluded directories are still watched in order to detect the removal of the exclude file
+		std::error_code ec;
+		if (!_excludeDirFileName.empty() && std::filesystem::exists(directory / _excludeDirFileName, ec))
+		{
+			LMS_LOG(DBUPDATER, DEBUG) << "Found '" << (directory / _excludeDirFileName).string() << "': not watching sub directories";
+			return;
+		}
+
+		std::filesystem::directory_iterator itPath {directory, std::filesystem::directory_options::follow_directory_symlink, ec};
+		const std::filesystem::directory_iterator itEnd;
+		while (!ec && itPath != itEnd)
+		{
+			if (std::filesystem::is_directory(*itPath, ec) && !ec)
+				addWatchRecursive(*itPath);
+
+			itPath.increment(ec);
+		}
+	}
+
+	void
+	MediaDirectoryWatcher::processEvents()
+	{
+		alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+
+		while (true)
+		{
+			const ssize_t length {::read(_inotifyFd, buffer.data(), buffer.size())};
+			if (length <= 0)
+				return;
+
+			for (const char* ptr {buffer.data()}; ptr < buffer.data() + length; )
+			{
+				const inotify_event* event {reinterpret_cast<const inotify_event*>(ptr)};
+				ptr += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					LMS_LOG(DBUPDATER, INFO) << "Some media directory events were lost";
+					_callback(_rootDirectory);
+					continue;
+				}
+
+				auto itDirectory {_watchedDirectories.find(event->wd)};
+				if (itDirectory == std::cend(_watchedDirectories))
+					continue;
+
+				if (event->mask & IN_IGNORED)
+				{
+					_watchedDirectories.erase(itDirectory);
+					continue;
+				}
+
+				if (event->mask & IN_DELETE_SELF)
+				{
+					_callback(itDirectory->second);
+					continue;
+				}
+
+				if (event->len == 0)
+					continue;
+
+				const std::filesystem::path path {itDirectory->second / event->name};
+
+				// Adding or removing the exclude file affects the whole directory
+				if (!_excludeDirFileName.empty() && path.filename() == _excludeDirFileName)
+				{
+					const std::filesystem::path directory {itDirectory->second};
+					if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+						addWatchRecursive(directory);
+
+					_callback(directory);
+					continue;
+				}
+
+				if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+					addWatchRecursive(path);
+
+				_callback(path);
+			}
+		}
+	}
+} // namespace Scanner
+
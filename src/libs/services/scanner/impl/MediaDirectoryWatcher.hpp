@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+namespace Scanner
+{
+	// Watches a directory tree using inotify, in a dedicated thread
+	// Reports the touched paths (files or directories), the root directory is reported if some events were lost
+	class MediaDirectoryWatcher
+	{
+		public:
+			using ChangeCallback = std::function<void(const std::filesystem::path&)>;
+
+			MediaDirectoryWatcher(const std::filesystem::path& rootDirectory, const std::filesystem::path& excludeDirFileName, ChangeCallback callback);
+			~MediaDirectoryWatcher();
+
+			MediaDirectoryWatcher(const MediaDirectoryWatcher&) = delete;
+			MediaDirectoryWatcher(MediaDirectoryWatcher&&) = delete;
+			MediaDirectoryWatcher& operator=(const MediaDirectoryWatcher&) = delete;
+			MediaDirectoryWatcher& operator=(MediaDirectoryWatcher&&) = delete;
+
+			const std::filesystem::path& getRootDirectory() const { return _rootDirectory; }
+
+		private:
+			void run();
+			void addWatchRecursive(const std::filesystem::path& directory);
+			void processEvents();
+
+			const std::filesystem::path	_rootDirectory;
+			const std::filesystem::path	_excludeDirFileName;
+			ChangeCallback				_callback;
+
+			int		_inotifyFd {-1};
+			int		_stopFd {-1};
+
+			// Only accessed from the watcher thread
+			std::unordered_map<int, std::filesystem::path>	_watchedDirectories;
+
+			std::thread	_thread;
+	};
+} // namespace Scanner
+
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ScanCache.hpp"
+
+#include <algorithm>
+
+#include "services/database/Session.hpp"
+#include "utils/Logger.hpp"
+#include "utils/UUID.hpp"
+
+using namespace Database;
+
+namespace Scanner
+{
+	namespace
+	{
+		template <typename T>
+		const std::vector<typename T::pointer>&
+		getEmptyResults()
+		{
+			static const std::vector<typename T::pointer> emptyResults;
+			return emptyResults;
+		}
+
+		// Keep the same order as in the database lookups: MBID entries first
+		template <typename T>
+		void
+		addByName(std::vector<typename T::pointer>& entries, const typename T::pointer& entry)
+		{
+			if (std::find(std::cbegin(entries), std::cend(entries), entry) != std::cend(entries))
+				return;
+
+			if (entry->getMBID())
+				entries.insert(std::begin(entries), entry);
+			else
+				entries.push_back(entry);
+		}
+	}
+
+	void
+	ScanCache::warm(Session& session, const std::set<std::string>& clusterTypeNames)
+	{
+		clear();
+
+		for (const Artist::pointer& artist : Artist::findAll(session))
+			addArtist(artist);
+
+		for (const Release::pointer& release : Release::findAll(session))
+			addRelease(release);
+
+		for (const std::string& clusterTypeName : clusterTypeNames)
+		{
+			const ClusterType::pointer clusterType {ClusterType::find(session, clusterTypeName)};
+			_clusterTypesByName.emplace(clusterTypeName, clusterType);
+			if (!clusterType)
+				continue;
+
+			for (const Cluster::pointer& cluster : clusterType->getClusters())
+				_clustersByTypeAndName.emplace(std::make_pair(clusterType->getId(), cluster->getName()), cluster);
+		}
+
+		LMS_LOG(DBUPDATER, DEBUG) << "Scan cache warmed: " << _artistsByName.size() << " artist name(s), " << _releasesByName.size() << " release name(s), " << _clustersByTypeAndName.size() << " cluster(s)";
+	}
+
+	void
+	ScanCache::clear()
+	{
+		_artistsByMBID.clear();
+		_artistsByName.clear();
+		_releasesByMBID.clear();
+		_releasesByName.clear();
+		_clusterTypesByName.clear();
+		_clustersByTypeAndName.clear();
+	}
+
+	Artist::pointer
+	ScanCache::findArtist(Session& session, const UUID& mbid)
+	{
+		const std::string key {mbid.getAsString()};
+
+		auto it {_artistsByMBID.find(key)};
+		if (it != std::cend(_artistsByMBID))
+			return it->second;
+
+		Artist::pointer artist {Artist::find(session, mbid)};
+		if (artist)
+			_artistsByMBID.emplace(key, artist);
+
+		return artist;
+	}
+
+	const std::vector<Artist::pointer>&
+	ScanCache::findArtists(Session& session, const std::string& name)
+	{
+		auto it {_artistsByName.find(name)};
+		if (it != std::cend(_artistsByName))
+			return it->second;
+
+		std::vector<Artist::pointer> artists {Artist::find(session, name)};
+		if (artists.empty())
+			return getEmptyResults<Artist>();
+
+		return _artistsByName.emplace(name, std::move(artists)).first->second;
+	}
+
+	void
+	ScanCache::onArtistCreated(const Artist::pointer& artist)
+	{
+		addArtist(artist);
+	}
+
+	void
+	ScanCache::onArtistRenamed(const Artist::pointer& artist, const std::string& oldName)
+	{
+		// Just drop the entries, they will be looked up again if needed
+		_artistsByName.erase(oldName);
+		_artistsByName.erase(artist->getName());
+	}
+
+	Release::pointer
+	ScanCache::findRelease(Session& session, const UUID& mbid)
+	{
+		const std::string key {mbid.getAsString()};
+
+		auto it {_releasesByMBID.find(key)};
+		if (it != std::cend(_releasesByMBID))
+			return it->second;
+
+		Release::pointer release {Release::find(session, mbid)};
+		if (release)
+			_releasesByMBID.emplace(key, release);
+
+		return release;
+	}
+
+	const std::vector<Release::pointer>&
+	ScanCache::findReleases(Session& session, const std::string& name)
+	{
+		auto it {_releasesByName.find(name)};
+		if (it != std::cend(_releasesByName))
+			return it->second;
+
+		std::vector<Release::pointer> releases {Release::find(session, name)};
+		if (releases.empty())
+			return getEmptyResults<Release>();
+
+		return _releasesByName.emplace(name, std::move(releases)).first->second;
+	}
+
+	void
+	ScanCache::onReleaseCreated(const Release::pointer& release)
+	{
+		addRelease(release);
+	}
+
+	void
+	ScanCache::onReleaseRenamed(const Release::pointer& release, const std::string& oldName)
+	{
+		_releasesByName.erase(oldName);
+		_releasesByName.erase(release->getName());
+	}
+
+	ClusterType::pointer
+	ScanCache::findClusterType(Session& session, const std::string& name)
+	{
+		auto it {_clusterTypesByName.find(name)};
+		if (it != std::cend(_clusterTypesByName))
+			return it->second;
+
+		// The scanner never creates cluster types: also cache missing entries
+		const ClusterType::pointer clusterType {ClusterType::find(session, name)};
+		_clusterTypesByName.emplace(name, clusterType);
+
+		return clusterType;
+	}
+
+	Cluster::pointer
+	ScanCache::findCluster(const ClusterType::pointer& clusterType, const std::string& name)
+	{
+		auto key {std::make_pair(clusterType->getId(), name)};
+
+		auto it {_clustersByTypeAndName.find(key)};
+		if (it != std::cend(_clustersByTypeAndName))
+			return it->second;
+
+		Cluster::pointer cluster {clusterType->getCluster(name)};
+		if (cluster)
+			_clustersByTypeAndName.emplace(std::move(key), cluster);
+
+		return cluster;
+	}
+
+	void
+	ScanCache::onClusterCreated(const ClusterType::pointer& clusterType, const std::string& name, const Cluster::pointer& cluster)
+	{
+		_clustersByTypeAndName.emplace(std::make_pair(clusterType->getId(), name), cluster);
+	}
+
+	void
+	ScanCache::addArtist(const Artist::pointer& artist)
+	{
+		if (const auto mbid {artist->getMBID()})
+			_artistsByMBID.emplace(mbid->getAsString(), artist);
+
+		addByName<Artist>(_artistsByName[artist->getName()], artist);
+	}
+
+	void
+	ScanCache::addRelease(const Release::pointer& release)
+	{
+		if (const auto mbid {release->getMBID()})
+			_releasesByMBID.emplace(mbid->getAsString(), release);
+
+		addByName<Release>(_releasesByName[release->getName()], release);
+	}
+} // namespace Scanner
+
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "services/database/Artist.hpp"
+#include "services/database/Cluster.hpp"
+#include "services/database/Release.hpp"
+#include "services/database/Types.hpp"
+
+class UUID;
+
+namespace Database
+{
+	class Session;
+}
+
+namespace Scanner
+{
+	// Resolves artists, releases and clusters during a scan, without querying the database for each scanned file
+	// Entries not found in the cache are looked up in the database and then cached
+	// Created or modified entities must be reported to keep the cache coherent
+	class ScanCache
+	{
+		public:
+			// Must be called with the database locked
+			void warm(Database::Session& session, const std::set<std::string>& clusterTypeNames);
+			void clear();
+
+			// Must be called in a unique transaction
+			Database::Artist::pointer							findArtist(Database::Session& session, const UUID& mbid);
+			const std::vector<Database::Artist::pointer>&		findArtists(Database::Session& session, const std::string& name); // MBID entries first
+			void												onArtistCreated(const Database::Artist::pointer& artist);
+			void												onArtistRenamed(const Database::Artist::pointer& artist, const std::string& oldName);
+
+			Database::Release::pointer							findRelease(Database::Session& session, const UUID& mbid);
+			const std::vector<Database::Release::pointer>&		findReleases(Database::Session& session, const std::string& name);
+			void												onReleaseCreated(const Database::Release::pointer& release);
+			void												onReleaseRenamed(const Database::Release::pointer& release, const std::string& oldName);
+
+			Database::ClusterType::pointer						findClusterType(Database::Session& session, const std::string& name);
+			Database::Cluster::pointer							findCluster(const Database::ClusterType::pointer& clusterType, const std::string& name);
+			void												onClusterCreated(const Database::ClusterType::pointer& clusterType, const std::string& name, const Database::Cluster::pointer& cluster);
+
+		private:
+			void addArtist(const Database::Artist::pointer& artist);
+			void addRelease(const Database::Release::pointer& release);
+
+			// Holding the pointers keeps the objects loaded in the session
+			std::unordered_map<std::string, Database::Artist::pointer>				_artistsByMBID;
+			std::unordered_map<std::string, std::vector<Database::Artist::pointer>>	_artistsByName;
+			std::unordered_map<std::string, Database::Release::pointer>				_releasesByMBID;
+			std::unordered_map<std::string, std::vector<Database::Release::pointer>>	_releasesByName;
+			std::unordered_map<std::string, Database::ClusterType::pointer>			_clusterTypesByName;
+			std::map<std::pair<Database::ClusterTypeId, std::string>, Database::Cluster::pointer>	_clustersByTypeAndName;
+	};
+} // namespace Scanner
+
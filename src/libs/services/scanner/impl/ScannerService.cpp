@@ -20,6 +20,12 @@
 #include "ScannerService.hpp"
 
 #include <ctime>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
 #include <boost/asio/placeholders.hpp>
 
 #include <Wt/WLocalDateTime.h>
@@ -38,7 +44,8 @@
 #include "utils/Logger.hpp"
 #include "utils/Path.hpp"
 #include "utils/UUID.hpp"
-#include "AcousticBrainzUtils.hpp"
+#include "AcousticBrainzFeaturesFetcher.hpp"
+#include "ScanCache.hpp"
 
 using namespace Database;
 
@@ -76,29 +83,76 @@ isFileSupported(const std::filesystem::path& file, const std::vector<std::filesy
 	return (std::find(std::cbegin(extensions), std::cend(extensions), extension) != std::cend(extensions));
 }
 
+// Check if path is the directory itself or is located inside the directory
 bool
-isPathInMediaDirectory(const std::filesystem::path& path, const std::filesystem::path& rootPath)
+isPathInDirectory(const std::filesystem::path& path, const std::filesystem::path& directory)
 {
-	std::filesystem::path curPath = path;
+	auto itDirectory {std::cbegin(directory)};
+	auto itPath {std::cbegin(path)};
 
-	while (curPath.parent_path() != curPath)
+	for (; itDirectory != std::cend(directory); ++itDirectory, ++itPath)
 	{
-		curPath = curPath.parent_path();
-
-		std::error_code ec;
-		if (std::filesystem::exists(curPath / excludeDirFileName, ec))
+		if (itPath == std::cend(path) || *itPath != *itDirectory)
 			return false;
-
-		if (curPath == rootPath)
-			return true;
 	}
 
-	return false;
+	return true;
+}
+
+bool
+isPathInDirectories(const std::filesystem::path& path, const std::vector<std::filesystem::path>& directories)
+{
+	return std::any_of(std::cbegin(directories), std::cend(directories), [&](const std::filesystem::path& directory) { return isPathInDirectory(path, directory); });
 }
 
+// Checks if paths belong to the media directory, caching the result for each visited directory
+class MediaDirectoryChecker
+{
+	public:
+		MediaDirectoryChecker(const std::filesystem::path& rootDirectory)
+		: _rootDirectory {rootDirectory}
+		{}
+
+		bool
+		isPathInMediaDirectory(const std::filesystem::path& path)
+		{
+			if (path == _rootDirectory)
+				return true;
+
+			return isDirectoryInMediaDirectory(path.parent_path());
+		}
+
+	private:
+		bool
+		isDirectoryInMediaDirectory(const std::filesystem::path& directory)
+		{
+			auto it {_directories.find(directory.string())};
+			if (it != std::cend(_directories))
+				return it->second;
+
+			bool res;
+
+			std::error_code ec;
+			if (std::filesystem::exists(directory / excludeDirFileName, ec))
+				res = false;
+			else if (directory == _rootDirectory)
+				res = true;
+			else if (directory.parent_path() == directory)
+				res = false;
+			else
+				res = isDirectoryInMediaDirectory(directory.parent_path());
+
+			_directories.emplace(directory.string(), res);
+			return res;
+		}
+
+		const std::filesystem::path				_rootDirectory;
+		std::unordered_map<std::string, bool>	_directories;
+};
+
 static
 Artist::pointer
-createArtist(Session& session, const MetaData::Artist& artistInfo)
+createArtist(Session& session, ScanCache& scanCache, const MetaData::Artist& artistInfo)
 {
 	Artist::pointer artist {session.create<Artist>(artistInfo.name)};
 
@@ -107,17 +161,21 @@ createArtist(Session& session, const MetaData::Artist& artistInfo)
 	if (artistInfo.sortName)
 		artist.modify()->setSortName(*artistInfo.sortName);
 
+	scanCache.onArtistCreated(artist);
+
 	return artist;
 }
 
 static
 void
-updateArtistIfNeeded(Artist::pointer artist, const MetaData::Artist& artistInfo)
+updateArtistIfNeeded(ScanCache& scanCache, Artist::pointer artist, const MetaData::Artist& artistInfo)
 {
 	// Name may have been updated
 	if (artist->getName() != artistInfo.name)
 	{
+		const std::string oldName {artist->getName()};
 		artist.modify()->setName(artistInfo.name);
+		scanCache.onArtistRenamed(artist, oldName);
 	}
 
 	// Sortname may have been updated
@@ -128,7 +186,7 @@ updateArtistIfNeeded(Artist::pointer artist, const MetaData::Artist& artistInfo)
 }
 
 std::vector<Artist::pointer>
-getOrCreateArtists(Session& session, const std::vector<MetaData::Artist>& artistsInfo, bool allowFallbackOnMBIDEntries)
+getOrCreateArtists(Session& session, ScanCache& scanCache, const std::vector<MetaData::Artist>& artistsInfo, bool allowFallbackOnMBIDEntries)
 {
 	std::vector<Artist::pointer> artists;
 
@@ -139,11 +197,11 @@ getOrCreateArtists(Session& session, const std::vector<MetaData::Artist>& artist
 		// First try to get by MBID
 		if (artistInfo.musicBrainzArtistID)
 		{
-			artist = Artist::find(session, *artistInfo.musicBrainzArtistID);
+			artist = scanCache.findArtist(session, *artistInfo.musicBrainzArtistID);
 			if (!artist)
-				artist = createArtist(session, artistInfo);
+				artist = createArtist(session, scanCache, artistInfo);
 			else
-				updateArtistIfNeeded(artist, artistInfo);
+				updateArtistIfNeeded(scanCache, artist, artistInfo);
 
 			artists.emplace_back(std::move(artist));
 			continue;
@@ -152,7 +210,7 @@ getOrCreateArtists(Session& session, const std::vector<MetaData::Artist>& artist
 		// Fall back on artist name (collisions may occur)
 		if (!artistInfo.name.empty())
 		{
-			for (const Artist::pointer& sameNamedArtist : Artist::find(session, artistInfo.name))
+			for (const Artist::pointer& sameNamedArtist : scanCache.findArtists(session, artistInfo.name))
 			{
 				// Do not fallback on artist that is correctly tagged
 				if (!allowFallbackOnMBIDEntries && sameNamedArtist->getMBID())
@@ -164,9 +222,9 @@ getOrCreateArtists(Session& session, const std::vector<MetaData::Artist>& artist
 
 			// No Artist found with the same name and without MBID -> creating
 			if (!artist)
-				artist = createArtist(session, artistInfo);
+				artist = createArtist(session, scanCache, artistInfo);
 			else
-				updateArtistIfNeeded(artist, artistInfo);
+				updateArtistIfNeeded(scanCache, artist, artistInfo);
 
 			artists.emplace_back(std::move(artist));
 			continue;
@@ -177,22 +235,25 @@ getOrCreateArtists(Session& session, const std::vector<MetaData::Artist>& artist
 }
 
 Release::pointer
-getOrCreateRelease(Session& session, const MetaData::Album& album)
+getOrCreateRelease(Session& session, ScanCache& scanCache, const MetaData::Album& album)
 {
 	Release::pointer release;
 
 	// First try to get by MBID
 	if (album.musicBrainzAlbumID)
 	{
-		release = Release::find(session, *album.musicBrainzAlbumID);
+		release = scanCache.findRelease(session, *album.musicBrainzAlbumID);
 		if (!release)
 		{
 			release = session.create<Release>(album.name, album.musicBrainzAlbumID);
+			scanCache.onReleaseCreated(release);
 		}
 		else if (release->getName() != album.name)
 		{
 			// Name may have been updated
+			const std::string oldName {release->getName()};
 			release.modify()->setName(album.name);
+			scanCache.onReleaseRenamed(release, oldName);
 		}
 
 		return release;
@@ -201,7 +262,7 @@ getOrCreateRelease(Session& session, const MetaData::Album& album)
 	// Fall back on release name (collisions may occur)
 	if (!album.name.empty())
 	{
-		for (const Release::pointer& sameNamedRelease : Release::find(session, album.name))
+		for (const Release::pointer& sameNamedRelease : scanCache.findReleases(session, album.name))
 		{
 			// do not fallback on properly tagged releases
 			if (!sameNamedRelease->getMBID())
@@ -213,7 +274,10 @@ getOrCreateRelease(Session& session, const MetaData::Album& album)
 
 		// No release found with the same name and without MBID -> creating
 		if (!release)
+		{
 			release = session.create<Release>(album.name);
+			scanCache.onReleaseCreated(release);
+		}
 
 		return release;
 	}
@@ -222,21 +286,24 @@ getOrCreateRelease(Session& session, const MetaData::Album& album)
 }
 
 std::vector<Cluster::pointer>
-getOrCreateClusters(Session& session, const MetaData::Clusters& clustersNames)
+getOrCreateClusters(Session& session, ScanCache& scanCache, const MetaData::Clusters& clustersNames)
 {
 	std::vector< Cluster::pointer > clusters;
 
 	for (auto clusterNames : clustersNames)
 	{
-		auto clusterType = ClusterType::find(session, clusterNames.first);
+		auto clusterType = scanCache.findClusterType(session, clusterNames.first);
 		if (!clusterType)
 			continue;
 
 		for (auto clusterName : clusterNames.second)
 		{
-			auto cluster = clusterType->getCluster(clusterName);
+			auto cluster = scanCache.findCluster(clusterType, clusterName);
 			if (!cluster)
+			{
 				cluster = session.create<Cluster>(clusterType, clusterName);
+				scanCache.onClusterCreated(clusterType, clusterName, cluster);
+			}
 
 			clusters.push_back(cluster);
 		}
@@ -270,13 +337,44 @@ getParserReadStyle()
 	throw LmsException {"Invalid value for 'scanner-parser-read-style'"};
 }
 
+static
+std::size_t
+getParserThreadCount()
+{
+	const unsigned long configParserThreadCount {Service<IConfig>::get()->getULong("scanner-parser-thread-count", 0)};
+
+	return configParserThreadCount ? configParserThreadCount : std::max<unsigned long>(1, std::thread::hardware_concurrency());
+}
+
+static
+std::size_t
+getAcousticBrainzMaxConcurrentRequests()
+{
+	return std::max<unsigned long>(1, Service<IConfig>::get()->getULong("acousticbrainz-max-concurrent-requests", 4));
+}
+
+static
+std::size_t
+getWriteBatchSize()
+{
+	return std::max<unsigned long>(1, Service<IConfig>::get()->getULong("scanner-write-batch-size", 100));
+}
+
 ScannerService::ScannerService(Db& db, Recommendation::IRecommendationService& recommendationService)
 : _recommendationService {recommendationService}
 , _skipDuplicateRecordingMBID {Service<IConfig>::get()->getBool("scanner-skip-duplicate-recording-mbid", false)}
 , _dbSession {db}
-, _metadataParser {MetaData::createParser(MetaData::ParserType::TagLib, getParserReadStyle())} // For now, always use TagLib
+, _parserReadStyle {getParserReadStyle()}
+, _parserThreadCount {getParserThreadCount()}
+, _writeBatchSize {getWriteBatchSize()}
+, _writeBatchMaxDuration {Service<IConfig>::get()->getULong("scanner-write-batch-max-duration-ms", 500)}
+, _watchMediaDirectory {Service<IConfig>::get()->getBool("scanner-watch-media-directory", false)}
+, _watchDebounceDelay {Service<IConfig>::get()->getULong("scanner-watch-debounce-seconds", 10)}
 {
 	LMS_LOG(DBUPDATER, INFO) << "skipDuplicateRecordingMBID = " << _skipDuplicateRecordingMBID;
+	LMS_LOG(DBUPDATER, INFO) << "parserThreadCount = " << _parserThreadCount;
+	LMS_LOG(DBUPDATER, INFO) << "writeBatchSize = " << _writeBatchSize << ", writeBatchMaxDuration = " << _writeBatchMaxDuration.count() << " ms";
+	LMS_LOG(DBUPDATER, INFO) << "watchMediaDirectory = " << _watchMediaDirectory << ", watchDebounceDelay = " << _watchDebounceDelay.count() << " s";
 
 	_ioService.setThreadCount(1);
 
@@ -320,8 +418,10 @@ ScannerService::stop()
 
 	_abortScan = true;
 	_scheduleTimer.cancel();
+	_watchDebounceTimer.cancel();
 	_recommendationService.cancelLoad();
 	_ioService.stop();
+	_mediaDirectoryWatcher.reset();
 }
 
 void
@@ -334,8 +434,11 @@ ScannerService::abortScan()
 
 	_abortScan = true;
 	_scheduleTimer.cancel();
+	_watchDebounceTimer.cancel();
 	_recommendationService.cancelLoad();
 	_ioService.stop();
+	// Pending changes will be handled by the next scan
+	_changedPaths.clear();
 	LMS_LOG(DBUPDATER, DEBUG) << "Scan abort done!";
 
 	_abortScan = false;
@@ -389,6 +492,7 @@ ScannerService::scheduleNextScan()
 	LMS_LOG(DBUPDATER, INFO) << "Scheduling next scan";
 
 	refreshScanSettings();
+	refreshMediaDirectoryWatcher();
 
 	const Wt::WDateTime now {Wt::WLocalDateTime::currentServerDateTime().toUTC()};
 
@@ -437,29 +541,74 @@ ScannerService::scheduleNextScan()
 	_events.scanScheduled.emit(_nextScheduledScan);
 }
 
-void
-ScannerService::countAllFiles(ScanStats& stats)
+ScannerService::DiscoveryResult
+ScannerService::discoverFiles(ScanStats& stats)
 {
+	DiscoveryResult result;
+
 	ScanStepStats stepStats{stats.startTime, ScanProgressStep::DiscoveringFiles};
 
 	stats.filesScanned = 0;
 	notifyInProgress(stepStats);
 
-	exploreFilesRecursive(_mediaDirectory, [&](std::error_code ec, const std::filesystem::path& path)
+	discoverFiles(_mediaDirectory, result, stats, [&]
+	{
+		stepStats.processedElems++;
+		notifyInProgressIfNeeded(stepStats);
+	});
+	notifyInProgress(stepStats);
+
+	const std::uintmax_t totalSize {std::accumulate(std::cbegin(result.files), std::cend(result.files), std::uintmax_t {}, [](std::uintmax_t size, const DiscoveredFile& file) { return size + file.size; })};
+	LMS_LOG(DBUPDATER, DEBUG) << "Discovered " << result.files.size() << " file(s), total size = " << (totalSize / (1024 * 1024)) << " MiB";
+
+	return result;
+}
+
+void
+ScannerService::discoverFiles(const std::filesystem::path& directory, DiscoveryResult& result, ScanStats& stats, std::function<void()> onFileDiscovered)
+{
+	exploreFilesRecursive(directory, [&](std::error_code ec, const std::filesystem::path& path)
 	{
 		if (_abortScan)
 			return false;
 
-		if (!ec && isFileSupported(path, _fileExtensions))
+		if (ec)
 		{
-			stats.filesScanned++;
-			stepStats.processedElems++;
-			notifyInProgressIfNeeded(stepStats);
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot process entry '" << path.string() << "': " << ec.message();
+			stats.errors.emplace_back(ScanError {path, ScanErrorType::CannotReadFile, ec.message()});
+			result.unreadablePaths.push_back(path);
+		}
+		else if (isFileSupported(path, _fileExtensions))
+		{
+			discoverFile(path, result, stats);
+
+			if (onFileDiscovered)
+				onFileDiscovered();
 		}
 
 		return true;
 	}, excludeDirFileName);
-	notifyInProgress(stepStats);
+}
+
+void
+ScannerService::discoverFile(const std::filesystem::path& file, DiscoveryResult& result, ScanStats& stats)
+{
+	try
+	{
+		const FileInfo fileInfo {getFileInfo(file)};
+
+		result.files.emplace_back(DiscoveredFile {file, fileInfo.lastWriteTime, fileInfo.size});
+	}
+	catch (LmsException& e)
+	{
+		LMS_LOG(DBUPDATER, ERROR) << e.what();
+		stats.skips++;
+
+		// May be a transient error: the existing track, if any, must be kept
+		result.unreadablePaths.push_back(file);
+	}
+
+	stats.filesScanned++;
 }
 
 void
@@ -509,16 +658,21 @@ ScannerService::scan(bool forceScan)
 
 	refreshScanSettings();
 
-	removeMissingTracks(stats);
-
-	LMS_LOG(DBUPDATER, DEBUG) << "Counting files in media directory '" << _mediaDirectory.string() << "'...";
-	countAllFiles(stats);
+	LMS_LOG(DBUPDATER, DEBUG) << "Discovering files in media directory '" << _mediaDirectory.string() << "'...";
+	const DiscoveryResult discovery {discoverFiles(stats)};
 	LMS_LOG(DBUPDATER, DEBUG) << "-> Nb files = " << stats.filesScanned;
 
+	removeMissingTracks(discovery, stats);
+
 	LMS_LOG(UI, INFO) << "Checks complete, force scan = " << forceScan;
 
 	LMS_LOG(DBUPDATER, INFO) << "scaning media directory '" << _mediaDirectory.string() << "'...";
-	scanMediaDirectory(_mediaDirectory, forceScan, stats);
+	{
+		auto transaction {_dbSession.createSharedTransaction()};
+		_scanCache.warm(_dbSession, _clusterTypeNames);
+	}
+	// Compare files against what is already in database in memory, to avoid a query for each unchanged file
+	scanFiles(discovery.files, forceScan ? KnownFileInfoMap {} : getKnownFileInfos(), forceScan, stats);
 	LMS_LOG(DBUPDATER, INFO) << "scaning media directory '" << _mediaDirectory.string() << "' DONE";
 
 	removeOrphanEntries();
@@ -560,30 +714,168 @@ ScannerService::scan(bool forceScan)
 	}
 }
 
-bool
-ScannerService::fetchTrackFeatures(TrackId trackId, const UUID& recordingMBID)
+void
+ScannerService::refreshMediaDirectoryWatcher()
 {
-	std::map<std::string, double> features;
+	if (!_watchMediaDirectory)
+		return;
+
+	if (_mediaDirectoryWatcher && _mediaDirectoryWatcher->getRootDirectory() == _mediaDirectory)
+		return;
+
+	_mediaDirectoryWatcher.reset();
+	_changedPaths.clear();
+
+	if (_mediaDirectory.empty())
+		return;
 
-	LMS_LOG(DBUPDATER, INFO) << "Fetching low level features for recording '" << recordingMBID.getAsString() << "'";
-	const std::string data {AcousticBrainz::extractLowLevelFeatures(recordingMBID)};
-	if (data.empty())
+	try
+	{
+		_mediaDirectoryWatcher = std::make_unique<MediaDirectoryWatcher>(_mediaDirectory, excludeDirFileName, [this](const std::filesystem::path& path)
+		{
+			// Called from the watcher thread
+			_ioService.post([this, path] { onMediaDirectoryChanged(path); });
+		});
+	}
+	catch (LmsException& e)
 	{
-		LMS_LOG(DBUPDATER, ERROR) << "Track " << trackId.getValue() << ", recording MBID = '" << recordingMBID.getAsString() << "': cannot extract features using AcousticBrainz";
-		return false;
+		LMS_LOG(DBUPDATER, ERROR) << "Cannot watch media directory '" << _mediaDirectory.string() << "': " << e.what();
 	}
+}
+
+void
+ScannerService::onMediaDirectoryChanged(const std::filesystem::path& path)
+{
+	LMS_LOG(DBUPDATER, DEBUG) << "Change detected on '" << path.string() << "'";
+	_changedPaths.insert(path);
 
+	// Wait for the changes to settle down before scanning
+	_watchDebounceTimer.expires_after(_watchDebounceDelay);
+	_watchDebounceTimer.async_wait([this](boost::system::error_code ec)
 	{
-		auto uniqueTransaction {_dbSession.createUniqueTransaction()};
+		if (ec)
+			return;
 
-		Track::pointer track {Track::find(_dbSession, trackId)};
-		if (!track)
-			return false;
+		scanChangedPaths();
+	});
+}
+
+void
+ScannerService::scanChangedPaths()
+{
+	if (_abortScan)
+		return;
+
+	// Only keep the topmost paths: std::filesystem::path sorts children right after their parents
+	std::vector<std::filesystem::path> changedPaths;
+	for (const std::filesystem::path& path : _changedPaths)
+	{
+		if (!changedPaths.empty() && isPathInDirectory(path, changedPaths.back()))
+			continue;
 
-		_dbSession.create<TrackFeatures>(track, data);
+		changedPaths.push_back(path);
 	}
+	_changedPaths.clear();
 
-	return true;
+	LMS_LOG(DBUPDATER, INFO) << "Scanning " << changedPaths.size() << " changed path(s)";
+
+	_events.scanStarted.emit();
+	{
+		std::unique_lock lock {_statusMutex};
+		_curState = State::InProgress;
+	}
+
+	ScanStats stats;
+	stats.startTime = Wt::WLocalDateTime::currentDateTime().toUTC();
+
+	DiscoveryResult discovery;
+	MediaDirectoryChecker mediaDirectoryChecker {_mediaDirectory};
+	for (const std::filesystem::path& path : changedPaths)
+	{
+		std::error_code ec;
+
+		// Nothing is discovered in excluded directories: their tracks are removed below
+		if (!mediaDirectoryChecker.isPathInMediaDirectory(path))
+			continue;
+
+		if (std::filesystem::exists(path / excludeDirFileName, ec))
+		{
+			LMS_LOG(DBUPDATER, INFO) << "Found '" << (path / excludeDirFileName).string() << "': removing the tracks of this directory";
+			continue;
+		}
+
+		if (std::filesystem::is_directory(path, ec))
+			discoverFiles(path, discovery, stats);
+		else if (std::filesystem::is_regular_file(path, ec) && isFileSupported(path, _fileExtensions))
+			discoverFile(path, discovery, stats);
+	}
+
+	// Only the tracks located in the changed paths are considered
+	std::vector<Track::FileInfoResult> fileInfos;
+	{
+		auto transaction {_dbSession.createSharedTransaction()};
+
+		for (const std::filesystem::path& path : changedPaths)
+		{
+			RangeResults<Track::FileInfoResult> pathFileInfos {Track::findFileInfos(_dbSession, path, Range {})};
+			fileInfos.insert(std::end(fileInfos), std::make_move_iterator(std::begin(pathFileInfos.results)), std::make_move_iterator(std::end(pathFileInfos.results)));
+		}
+	}
+
+	// Remove the tracks located in the changed paths that have not been discovered again
+	{
+		std::unordered_set<std::string> discoveredPaths;
+		for (const DiscoveredFile& file : discovery.files)
+			discoveredPaths.insert(file.path.string());
+
+		std::vector<TrackId> tracksToRemove;
+		for (const Track::FileInfoResult& fileInfo : fileInfos)
+		{
+			if (isPathInDirectories(fileInfo.path, discovery.unreadablePaths))
+				continue;
+
+			if (discoveredPaths.find(fileInfo.path.string()) == std::cend(discoveredPaths))
+			{
+				LMS_LOG(DBUPDATER, INFO) << "Removing '" << fileInfo.path.string() << "': missing or no longer in media directory";
+				tracksToRemove.push_back(fileInfo.trackId);
+			}
+		}
+
+		removeTracks(tracksToRemove, stats);
+	}
+
+	KnownFileInfoMap knownFileInfos;
+	for (const Track::FileInfoResult& fileInfo : fileInfos)
+		knownFileInfos.emplace(fileInfo.path.string(), KnownFileInfo {fileInfo.lastWriteTime.toTime_t(), fileInfo.scanVersion});
+
+	// The scan cache is not warmed: only a few entries are likely to be used
+	scanFiles(discovery.files, knownFileInfos, false, stats);
+
+	if (!_abortScan && stats.nbChanges() > 0)
+	{
+		removeOrphanEntries();
+		fetchTrackFeatures(stats);
+		reloadSimilarityEngine(stats);
+	}
+
+	LMS_LOG(DBUPDATER, INFO) << "Changed paths scan " << (_abortScan ? "aborted" : "complete") << ". Changes = " << stats.nbChanges() << " (added = " << stats.additions << ", removed = " << stats.deletions << ", updated = " << stats.updates << ")";
+
+	{
+		std::unique_lock lock {_statusMutex};
+
+		// Same as full scans: aborting cancels the scheduled scan
+		if (_abortScan)
+			_curState = State::NotScheduled;
+		else
+			_curState = _nextScheduledScan.isValid() ? State::Scheduled : State::NotScheduled;
+		_currentScanStepStats.reset();
+	}
+
+	if (!_abortScan)
+	{
+		stats.stopTime = Wt::WLocalDateTime::currentDateTime().toUTC();
+		_events.scanComplete.emit(stats);
+	}
 }
 
 void
@@ -596,44 +888,101 @@ ScannerService::fetchTrackFeatures(ScanStats& stats)
 
 	LMS_LOG(DBUPDATER, INFO) << "Fetching missing track features...";
 
-	struct TrackInfo
-	{
-		TrackId id;
-		UUID recordingMBID;
-	};
-
-	const auto tracksToFetch {[&]()
+	// Several tracks may share the same recording
+	std::map<std::string, std::vector<TrackId>> tracksByRecordingMBID;
+	std::size_t trackCount {};
 	{
-		std::vector<TrackInfo> res;
-
 		auto transaction {_dbSession.createSharedTransaction()};
 
 		auto trackIds {Track::findWithRecordingMBIDAndMissingFeatures(_dbSession, Range {})};
 		for (const TrackId trackId : trackIds.results)
 		{
 			const Track::pointer track {Track::find(_dbSession, trackId)};
-			res.emplace_back(TrackInfo {track->getId(), *track->getRecordingMBID()});
+			tracksByRecordingMBID[std::string {track->getRecordingMBID()->getAsString()}].push_back(trackId);
 		}
 
-		return res;
-	}()};
+		trackCount = trackIds.results.size();
+	}
 
-	stepStats.totalElems = tracksToFetch.size();
+	stepStats.totalElems = trackCount;
 	notifyInProgress(stepStats);
 
-	LMS_LOG(DBUPDATER, INFO) << "Found " << tracksToFetch.size() << " track(s) to fetch!";
+	LMS_LOG(DBUPDATER, INFO) << "Found " << trackCount << " track(s) to fetch, " << tracksByRecordingMBID.size() << " recording(s)!";
+	if (tracksByRecordingMBID.empty())
+		return;
+
+	const bool keepRawData {Service<IConfig>::get()->getBool("acousticbrainz-keep-raw-data", false)};
+	AcousticBrainz::FeaturesFetcher fetcher {Service<IConfig>::get()->getString("acousticbrainz-api-base-url", "https://acousticbrainz.org"), getAcousticBrainzMaxConcurrentRequests()};
+	{
+		std::vector<UUID> recordingMBIDs;
+		for (const auto& [recordingMBID, trackIds] : tracksByRecordingMBID)
+			recordingMBIDs.push_back(*UUID::fromString(recordingMBID));
+
+		fetcher.pushRequests(recordingMBIDs);
+	}
+
+	std::deque<AcousticBrainz::FeaturesFetcher::Result> results;
+	std::chrono::steady_clock::time_point oldestResultTime; // only meaningful if results is not empty
+
+	// Results waiting for too long are written even if the batch is not full
+	auto writeResults {[&](bool flush)
+	{
+		while (!_abortScan && (results.size() >= _writeBatchSize
+					|| (!results.empty() && (flush || std::chrono::steady_clock::now() - oldestResultTime >= _writeBatchMaxDuration))))
+		{
+			{
+				const auto batchStartTime {std::chrono::steady_clock::now()};
+				auto uniqueTransaction {_dbSession.createUniqueTransaction()};
+
+				for (std::size_t i {}; i < _writeBatchSize && !results.empty() && !_abortScan; ++i)
+				{
+					const AcousticBrainz::FeaturesFetcher::Result& result {results.front()};
+					// Tracks without stored features will be fetched again on next scan
+					const std::vector<unsigned char> features {result.data.empty() ? std::vector<unsigned char> {} : TrackFeatures::encodeFeatures(result.data)};
+
+					for (const TrackId trackId : tracksByRecordingMBID[std::string {result.recordingMBID.getAsString()}])
+					{
+						if (features.empty())
+						{
+							LMS_LOG(DBUPDATER, ERROR) << "Track " << trackId.getValue() << ", recording MBID = '" << result.recordingMBID.getAsString() << "': cannot extract features using AcousticBrainz";
+						}
+						else if (Track::pointer track {Track::find(_dbSession, trackId)})
+						{
+							_dbSession.create<TrackFeatures>(track, features, keepRawData ? result.data : std::string {});
+							stats.featuresFetched++;
+						}
+
+						stepStats.processedElems++;
+					}
+
+					results.pop_front();
+
+					if (std::chrono::steady_clock::now() - batchStartTime > _writeBatchMaxDuration)
+						break;
+				}
+			}
+
+			notifyInProgressIfNeeded(stepStats);
+		}
+	}};
 
-	for (const TrackInfo& trackToFetch : tracksToFetch)
+	while (fetcher.getPendingCount() > 0)
 	{
+		fetcher.waitForResults(_writeBatchMaxDuration);
 		if (_abortScan)
 			return;
 
-		if (fetchTrackFeatures(trackToFetch.id, trackToFetch.recordingMBID))
-			stats.featuresFetched++;
+		for (AcousticBrainz::FeaturesFetcher::Result& result : fetcher.popResults())
+		{
+			if (results.empty())
+				oldestResultTime = std::chrono::steady_clock::now();
 
-		stepStats.processedElems++;
-		notifyInProgressIfNeeded(stepStats);
+			results.emplace_back(std::move(result));
+		}
+
+		writeResults(false);
 	}
+	writeResults(true);
 
 	notifyInProgress(stepStats);
 	LMS_LOG(DBUPDATER, INFO) << "Track features fetched!";
@@ -662,13 +1011,11 @@ ScannerService::refreshScanSettings()
 	_recommendationServiceType = scanSettings->getRecommendationEngineType();
 
 	const auto clusterTypes = scanSettings->getClusterTypes();
-	std::set<std::string> clusterTypeNames;
+	_clusterTypeNames.clear();
 
 	std::transform(std::cbegin(clusterTypes), std::cend(clusterTypes),
-			std::inserter(clusterTypeNames, clusterTypeNames.begin()),
+			std::inserter(_clusterTypeNames, _clusterTypeNames.begin()),
 			[](ClusterType::pointer clusterType) { return clusterType->getName(); });
-
-	_metadataParser->setClusterTypeNames(clusterTypeNames);
 }
 
 void
@@ -693,37 +1040,46 @@ ScannerService::notifyInProgressIfNeeded(const ScanStepStats& stepStats)
 		notifyInProgress(stepStats);
 }
 
-void
-ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanStats& stats)
+ScannerService::KnownFileInfoMap
+ScannerService::getKnownFileInfos()
 {
-	Wt::WDateTime lastWriteTime;
-	try
-	{
-		lastWriteTime = getLastWriteTime(file);
-	}
-	catch (LmsException& e)
-	{
-		LMS_LOG(DBUPDATER, ERROR) << e.what();
-		stats.skips++;
-		return;
-	}
+	KnownFileInfoMap knownFileInfos;
+
+	auto transaction {_dbSession.createSharedTransaction()};
 
+	const RangeResults<Track::FileInfoResult> fileInfos {Track::findFileInfos(_dbSession, Range {})};
+	knownFileInfos.reserve(fileInfos.results.size());
+	for (const Track::FileInfoResult& fileInfo : fileInfos.results)
+		knownFileInfos.emplace(fileInfo.path.string(), KnownFileInfo {fileInfo.lastWriteTime.toTime_t(), fileInfo.scanVersion});
+
+	return knownFileInfos;
+}
+
+bool
+ScannerService::checkFileNeedsScan(const DiscoveredFile& file, const KnownFileInfoMap& knownFileInfos, bool forceScan, ScanStats& stats)
+{
 	if (!forceScan)
 	{
 		// Skip file if last write is the same
-		auto transaction {_dbSession.createSharedTransaction()};
-
-		const Track::pointer track {Track::findByPath(_dbSession, file)};
+		auto it {knownFileInfos.find(file.path.string())};
 
-		if (track && track->getLastWriteTime().toTime_t() == lastWriteTime.toTime_t()
-				&& track->getScanVersion() == _scanVersion)
+		if (it != std::cend(knownFileInfos)
+				&& it->second.lastWriteTime == file.lastWriteTime.toTime_t()
+				&& it->second.scanVersion == _scanVersion)
 		{
 			stats.skips++;
-			return;
+			return false;
 		}
 	}
 
-	std::optional<MetaData::Track> trackInfo {_metadataParser->parse(file)};
+	return true;
+}
+
+void
+ScannerService::processFileScanResult(const FileScanQueue::ScanResult& scanResult, ScanStats& stats)
+{
+	const std::filesystem::path& file {scanResult.path};
+	const std::optional<MetaData::Track>& trackInfo {scanResult.trackInfo};
 	if (!trackInfo)
 	{
 		stats.errors.emplace_back(file, ScanErrorType::CannotParseFile);
@@ -732,7 +1088,7 @@ ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan,
 
 	stats.scans++;
 
-	auto uniqueTransaction {_dbSession.createUniqueTransaction()};
+	_dbSession.checkUniqueLocked();
 
 	Track::pointer track {Track::findByPath(_dbSession, file) };
 
@@ -748,6 +1104,7 @@ ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan,
 			// This recording MBID already exists, just remove what we just scanned
 			if (track)
 			{
+				_events.tracksRemoved.emit({track->getId()});
 				track.remove();
 				stats.deletions++;
 			}
@@ -765,6 +1122,7 @@ ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan,
 		// If Track exists here, delete it!
 		if (track)
 		{
+			_events.tracksRemoved.emit({track->getId()});
 			track.remove();
 			stats.deletions++;
 		}
@@ -778,6 +1136,7 @@ ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan,
 		// If Track exists here, delete it!
 		if (track)
 		{
+			_events.tracksRemoved.emit({track->getId()});
 			track.remove();
 			stats.deletions++;
 		}
@@ -817,45 +1176,45 @@ ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan,
 
 	track.modify()->clearArtistLinks();
 	// Do not fallback on artists with the same name but having a MBID for artist and releaseArtists, as it may be corrected by properly tagging files
-	for (const Artist::pointer& artist : getOrCreateArtists(_dbSession, trackInfo->artists, false))
+	for (const Artist::pointer& artist : getOrCreateArtists(_dbSession, _scanCache, trackInfo->artists, false))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, artist, TrackArtistLinkType::Artist));
 
-	for (const Artist::pointer& releaseArtist : getOrCreateArtists(_dbSession, trackInfo->albumArtists, false))
+	for (const Artist::pointer& releaseArtist : getOrCreateArtists(_dbSession, _scanCache, trackInfo->albumArtists, false))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, releaseArtist, TrackArtistLinkType::ReleaseArtist));
 
 	// Allow fallbacks on artists with the same name even if they have MBID, since there is no tag to indicate the MBID of these artists
 	// We could ask MusicBrainz to get all the information, but that would heavily slow down the import process
-	for (const Artist::pointer& conductor : getOrCreateArtists(_dbSession, trackInfo->conductorArtists, true))
+	for (const Artist::pointer& conductor : getOrCreateArtists(_dbSession, _scanCache, trackInfo->conductorArtists, true))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, conductor, TrackArtistLinkType::Conductor));
 
-	for (const Artist::pointer& composer : getOrCreateArtists(_dbSession, trackInfo->composerArtists, true))
+	for (const Artist::pointer& composer : getOrCreateArtists(_dbSession, _scanCache, trackInfo->composerArtists, true))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, composer, TrackArtistLinkType::Composer));
 
-	for (const Artist::pointer& lyricist : getOrCreateArtists(_dbSession, trackInfo->lyricistArtists, true))
+	for (const Artist::pointer& lyricist : getOrCreateArtists(_dbSession, _scanCache, trackInfo->lyricistArtists, true))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, lyricist, TrackArtistLinkType::Lyricist));
 
-	for (const Artist::pointer& mixer : getOrCreateArtists(_dbSession, trackInfo->mixerArtists, true))
+	for (const Artist::pointer& mixer : getOrCreateArtists(_dbSession, _scanCache, trackInfo->mixerArtists, true))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, mixer, TrackArtistLinkType::Mixer));
 
 	for (const auto& [role, performers] : trackInfo->performerArtists)
 	{
-		for (const Artist::pointer& performer : getOrCreateArtists(_dbSession, performers, true))
+		for (const Artist::pointer& performer : getOrCreateArtists(_dbSession, _scanCache, performers, true))
 			track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, performer, TrackArtistLinkType::Performer, role));
 	}
 
-	for (const Artist::pointer& producer : getOrCreateArtists(_dbSession, trackInfo->producerArtists, true))
+	for (const Artist::pointer& producer : getOrCreateArtists(_dbSession, _scanCache, trackInfo->producerArtists, true))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, producer, TrackArtistLinkType::Producer));
 
-	for (const Artist::pointer& remixer : getOrCreateArtists(_dbSession, trackInfo->remixerArtists, true))
+	for (const Artist::pointer& remixer : getOrCreateArtists(_dbSession, _scanCache, trackInfo->remixerArtists, true))
 		track.modify()->addArtistLink(TrackArtistLink::create(_dbSession, track, remixer, TrackArtistLinkType::Remixer));
 
 	track.modify()->setScanVersion(_scanVersion);
 	if (trackInfo->album)
-		track.modify()->setRelease(getOrCreateRelease(_dbSession, *trackInfo->album));
+		track.modify()->setRelease(getOrCreateRelease(_dbSession, _scanCache, *trackInfo->album));
 	else
 		track.modify()->setRelease({});
-	track.modify()->setClusters(getOrCreateClusters(_dbSession, trackInfo->clusters));
-	track.modify()->setLastWriteTime(lastWriteTime);
+	track.modify()->setClusters(getOrCreateClusters(_dbSession, _scanCache, trackInfo->clusters));
+	track.modify()->setLastWriteTime(scanResult.lastWriteTime);
 	track.modify()->setName(title);
 	track.modify()->setDuration(trackInfo->duration);
 	track.modify()->setAddedTime(Wt::WLocalDateTime::currentServerDateTime().toUTC());
@@ -883,52 +1242,120 @@ ScannerService::scanAudioFile(const std::filesystem::path& file, bool forceScan,
 }
 
 void
-ScannerService::scanMediaDirectory(const std::filesystem::path& mediaDirectory, bool forceScan, ScanStats& stats)
+ScannerService::scanFiles(const std::vector<DiscoveredFile>& files, const KnownFileInfoMap& knownFileInfos, bool forceScan, ScanStats& stats)
 {
+	// Limit the number of files being parsed or waiting to be written, to keep memory usage bounded
+	const std::size_t maxPendingCount {_parserThreadCount * 16};
+
 	ScanStepStats stepStats{stats.startTime, ScanProgressStep::ScanningFiles};
-	stepStats.totalElems = stats.filesScanned;
+	stepStats.totalElems = files.size();
 	notifyInProgress(stepStats);
 
-	exploreFilesRecursive(mediaDirectory, [&](std::error_code ec, const std::filesystem::path& path)
+	LMS_LOG(DBUPDATER, DEBUG) << "Found " << knownFileInfos.size() << " known file(s)";
+
+	// Files are parsed in the scan queue, and written to the database in this thread
+	FileScanQueue scanQueue {_parserThreadCount, _parserReadStyle, _clusterTypeNames, _abortScan};
+	std::deque<FileScanQueue::ScanResult> scanResults;
+	std::chrono::steady_clock::time_point oldestScanResultTime; // only meaningful if scanResults is not empty
+
+	// Write results in batches, releasing the database lock between batches to let readers in
+	// Results waiting for too long are written even if the batch is not full
+	auto writeScanResults {[&](bool flush)
+	{
+		while (!_abortScan && (scanResults.size() >= _writeBatchSize
+					|| (!scanResults.empty() && (flush || std::chrono::steady_clock::now() - oldestScanResultTime >= _writeBatchMaxDuration))))
+		{
+			{
+				const auto batchStartTime {std::chrono::steady_clock::now()};
+				auto uniqueTransaction {_dbSession.createUniqueTransaction()};
+
+				for (std::size_t i {}; i < _writeBatchSize && !scanResults.empty() && !_abortScan; ++i)
+				{
+					processFileScanResult(scanResults.front(), stats);
+					scanResults.pop_front();
+					stepStats.processedElems++;
+
+					if (std::chrono::steady_clock::now() - batchStartTime > _writeBatchMaxDuration)
+						break;
+				}
+			}
+
+			notifyInProgressIfNeeded(stepStats);
+		}
+	}};
+
+	auto processScanResults {[&](bool flush)
+	{
+		for (FileScanQueue::ScanResult& scanResult : scanQueue.popResults())
+		{
+			if (scanResults.empty())
+				oldestScanResultTime = std::chrono::steady_clock::now();
+
+			scanResults.emplace_back(std::move(scanResult));
+		}
+
+		writeScanResults(flush);
+	}};
+
+	for (const DiscoveredFile& file : files)
 	{
 		if (_abortScan)
-			return false;
+			break;
 
-		if (ec)
+		if (checkFileNeedsScan(file, knownFileInfos, forceScan, stats))
 		{
-			LMS_LOG(DBUPDATER, ERROR) << "Cannot process entry '" << path.string() << "': " << ec.message();
-			stats.errors.emplace_back(ScanError {path, ScanErrorType::CannotReadFile, ec.message()});
+			scanQueue.pushScanRequest({file.path, file.lastWriteTime});
 		}
-		else if (isFileSupported(path, _fileExtensions))
+		else
 		{
-			scanAudioFile(path, forceScan, stats );
-
 			stepStats.processedElems++;
 			notifyInProgressIfNeeded(stepStats);
 		}
 
-		return true;
-	}, excludeDirFileName);
+		processScanResults(false);
+		while (!_abortScan && scanQueue.getPendingCount() > maxPendingCount)
+		{
+			scanQueue.waitForResults(_writeBatchMaxDuration);
+			processScanResults(false);
+		}
+	}
+
+	while (!_abortScan && scanQueue.getPendingCount() > 0)
+	{
+		scanQueue.waitForResults(_writeBatchMaxDuration);
+		processScanResults(false);
+	}
+	processScanResults(true);
+
+	_scanCache.clear();
 
 	notifyInProgress(stepStats);
 }
 
 // Check if a file exists and is still in a media directory
+// Files that cannot be checked are considered as valid
 static bool
-checkFile(const std::filesystem::path& p, const std::filesystem::path& mediaDirectory, const std::vector<std::filesystem::path>& extensions)
+checkFile(const std::filesystem::path& p, MediaDirectoryChecker& mediaDirectoryChecker, const std::vector<std::filesystem::path>& extensions)
 {
 	try
 	{
 		// For each track, make sure the the file still exists
 		// and still belongs to a media directory
-		if (!std::filesystem::exists( p )
-			|| !std::filesystem::is_regular_file( p ) )
+		std::error_code ec;
+		const std::filesystem::file_status status {std::filesystem::status(p, ec)};
+		if (ec && ec != std::errc::no_such_file_or_directory)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot check file '" << p.string() << "': " << ec.message() << ", keeping it";
+			return true;
+		}
+
+		if (!std::filesystem::is_regular_file(status))
 		{
 			LMS_LOG(DBUPDATER, INFO) << "Removing '" << p.string() << "': missing";
 			return false;
 		}
 
-		if (!isPathInMediaDirectory(p, mediaDirectory))
+		if (!mediaDirectoryChecker.isPathInMediaDirectory(p))
 		{
 			LMS_LOG(DBUPDATER, INFO) << "Removing '" << p.string() << "': out of media directory";
 			return false;
@@ -944,75 +1371,95 @@ checkFile(const std::filesystem::path& p, const std::filesystem::path& mediaDire
 	}
 	catch (std::filesystem::filesystem_error& e)
 	{
-		LMS_LOG(DBUPDATER, ERROR) << "Caught exception while checking file '" << p.string() << "': " << e.what();
-		return false;
+		LMS_LOG(DBUPDATER, ERROR) << "Caught exception while checking file '" << p.string() << "': " << e.what() << ", keeping it";
+		return true;
 	}
 }
 
 void
-ScannerService::removeMissingTracks(ScanStats& stats)
+ScannerService::removeMissingTracks(const DiscoveryResult& discovery, ScanStats& stats)
 {
-	static constexpr std::size_t batchSize {50};
+	if (_abortScan)
+		return;
 
 	ScanStepStats stepStats{stats.startTime, ScanProgressStep::ChekingForMissingFiles};
 
 	LMS_LOG(DBUPDATER, DEBUG) << "Checking tracks to be removed...";
-	std::size_t trackCount {};
 
+	std::unordered_set<std::string> discoveredPaths;
+	discoveredPaths.reserve(discovery.files.size());
+	for (const DiscoveredFile& file : discovery.files)
+		discoveredPaths.insert(file.path.string());
+
+	RangeResults<Track::PathResult> trackPaths;
 	{
 		auto transaction {_dbSession.createSharedTransaction()};
-		trackCount = Track::getCount(_dbSession);
+		trackPaths = Track::findPaths(_dbSession, Range {});
 	}
-	LMS_LOG(DBUPDATER, DEBUG) << trackCount << " tracks to be checked...";
+	LMS_LOG(DBUPDATER, DEBUG) << trackPaths.results.size() << " tracks to be checked...";
 
-	stepStats.totalElems = trackCount;
+	stepStats.totalElems = trackPaths.results.size();
 	notifyInProgress(stepStats);
 
-	RangeResults<Track::PathResult> trackPaths;
-	std::vector<TrackId> tracksToRemove;
+	// Only tracks located in entries that could not be explored need to be checked on the file system
+	MediaDirectoryChecker mediaDirectoryChecker {_mediaDirectory};
 
-	for (std::size_t i {trackCount < batchSize ? 0 : trackCount - batchSize}; ; i -= (i > batchSize ? batchSize : i))
+	std::vector<TrackId> tracksToRemove;
+	for (const Track::PathResult& trackPath : trackPaths.results)
 	{
-		tracksToRemove.clear();
+		if (_abortScan)
+			return;
+
+		stepStats.processedElems++;
+		notifyInProgressIfNeeded(stepStats);
+
+		if (discoveredPaths.find(trackPath.path.string()) != std::cend(discoveredPaths))
+			continue;
 
+		if (isPathInDirectories(trackPath.path, discovery.unreadablePaths))
 		{
-			auto transaction {_dbSession.createSharedTransaction()};
-			trackPaths = Track::findPaths(_dbSession, Range {i, batchSize});
+			if (checkFile(trackPath.path, mediaDirectoryChecker, _fileExtensions))
+				continue;
 		}
-
-		for (const Track::PathResult& trackPath : trackPaths.results)
+		else
 		{
-			if (_abortScan)
-				return;
+			LMS_LOG(DBUPDATER, INFO) << "Removing '" << trackPath.path.string() << "': missing, out of media directory or file format no longer handled";
+		}
 
-			if (!checkFile(trackPath.path, _mediaDirectory, _fileExtensions))
-				tracksToRemove.push_back(trackPath.trackId);
+		tracksToRemove.push_back(trackPath.trackId);
+	}
 
-			stepStats.processedElems++;
-		}
+	removeTracks(tracksToRemove, stats);
+	notifyInProgress(stepStats);
 
-		if (!tracksToRemove.empty())
-		{
-			auto transaction {_dbSession.createUniqueTransaction()};
+	LMS_LOG(DBUPDATER, DEBUG) << trackPaths.results.size() << " tracks checked, " << tracksToRemove.size() << " removed!";
+}
 
-			for (const TrackId trackId : tracksToRemove)
+void
+ScannerService::removeTracks(const std::vector<TrackId>& trackIds, ScanStats& stats)
+{
+	if (trackIds.empty())
+		return;
+
+	// Some tracks may have already been removed in the meantime
+	std::vector<TrackId> removedTrackIds;
+	{
+		auto transaction {_dbSession.createUniqueTransaction()};
+
+		for (const TrackId trackId : trackIds)
+		{
+			Track::pointer track {Track::find(_dbSession, trackId)};
+			if (track)
 			{
-				Track::pointer track {Track::find(_dbSession, trackId)};
-				if (track)
-				{
-					track.remove();
-					stats.deletions++;
-				}
+				track.remove();
+				stats.deletions++;
+				removedTrackIds.push_back(trackId);
 			}
 		}
-
-		notifyInProgressIfNeeded(stepStats);
-
-		if (i == 0)
-			break;
 	}
 
-	LMS_LOG(DBUPDATER, DEBUG) << trackCount << " tracks checked!";
+	if (!removedTrackIds.empty())
+		_events.tracksRemoved.emit(removedTrackIds);
 }
 
 void
@@ -1043,6 +1490,8 @@ ScannerService::removeOrphanEntries()
 			LMS_LOG(DBUPDATER, DEBUG) << "Removing orphan artist '" << artist->getName() << "'";
 			artist.remove();
 		}
+
+		_events.artistsRemoved.emit(artistIds.results);
 	}
 
 	LMS_LOG(DBUPDATER, DEBUG) << "Checking orphan releases...";
@@ -1056,6 +1505,8 @@ ScannerService::removeOrphanEntries()
 			LMS_LOG(DBUPDATER, DEBUG) << "Removing orphan release '" << release->getName() << "'";
 			release.remove();
 		}
+
+		_events.releasesRemoved.emit(releases.results);
 	}
 
 	LMS_LOG(DBUPDATER, INFO) << "Check audio files done!";
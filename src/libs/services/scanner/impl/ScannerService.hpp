@@ -20,14 +20,20 @@
 #pragma once
 
 #include <chrono>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <set>
 #include <shared_mutex>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 #include <Wt/WDateTime.h>
 #include <Wt/WIOService.h>
 #include <Wt/WSignal.h>
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/system_timer.hpp>
 
 #include "services/database/Types.hpp"
@@ -36,6 +42,9 @@
 #include "metadata/IParser.hpp"
 #include "services/scanner/IScannerService.hpp"
 #include "utils/Path.hpp"
+#include "FileScanQueue.hpp"
+#include "MediaDirectoryWatcher.hpp"
+#include "ScanCache.hpp"
 
 class UUID;
 
@@ -64,6 +73,28 @@ namespace Scanner
 			Events&	getEvents() override { return _events; }
 
 		private:
+			// Files already known in database, indexed by path
+			struct KnownFileInfo
+			{
+				std::time_t	lastWriteTime;
+				std::size_t	scanVersion;
+			};
+			using KnownFileInfoMap = std::unordered_map<std::string, KnownFileInfo>;
+
+			// Supported files found in the media directory
+			struct DiscoveredFile
+			{
+				std::filesystem::path	path;
+				Wt::WDateTime			lastWriteTime;
+				std::uintmax_t			size {};
+			};
+
+			struct DiscoveryResult
+			{
+				std::vector<DiscoveredFile>			files;
+				std::vector<std::filesystem::path>	unreadablePaths; // entries that could not be explored or inspected
+			};
+
 			void start();
 			void stop();
 
@@ -76,18 +107,27 @@ namespace Scanner
 			// Update database (scheduled callback)
 			void scan(bool force);
 
-			void scanMediaDirectory( const std::filesystem::path& mediaDirectory, bool forceScan, ScanStats& stats);
-			bool fetchTrackFeatures(Database::TrackId trackId, const UUID& MBID);
+			// Watch mode
+			void refreshMediaDirectoryWatcher();
+			void onMediaDirectoryChanged(const std::filesystem::path& path);
+			void scanChangedPaths();
+
+			void scanFiles(const std::vector<DiscoveredFile>& files, const KnownFileInfoMap& knownFileInfos, bool forceScan, ScanStats& stats);
 			void fetchTrackFeatures(ScanStats& stats);
 
 			// Helpers
 			void refreshScanSettings();
 
-			void countAllFiles(ScanStats& stats);
-			void removeMissingTracks(ScanStats& stats);
+			DiscoveryResult discoverFiles(ScanStats& stats);
+			void discoverFiles(const std::filesystem::path& directory, DiscoveryResult& result, ScanStats& stats, std::function<void()> onFileDiscovered = {});
+			void discoverFile(const std::filesystem::path& file, DiscoveryResult& result, ScanStats& stats);
+			void removeMissingTracks(const DiscoveryResult& discovery, ScanStats& stats);
+			void removeTracks(const std::vector<Database::TrackId>& trackIds, ScanStats& stats);
 			void removeOrphanEntries();
 			void checkDuplicatedAudioFiles(ScanStats& stats);
-			void scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanStats& stats);
+			KnownFileInfoMap getKnownFileInfos();
+			bool checkFileNeedsScan(const DiscoveredFile& file, const KnownFileInfoMap& knownFileInfos, bool forceScan, ScanStats& stats);
+			void processFileScanResult(const FileScanQueue::ScanResult& scanResult, ScanStats& stats);
 			void notifyInProgressIfNeeded(const ScanStepStats& stats);
 			void notifyInProgress(const ScanStepStats& stats);
 			void reloadSimilarityEngine(ScanStats& stats);
@@ -98,11 +138,20 @@ namespace Scanner
 			std::atomic<bool>						_abortScan {};
 			Wt::WIOService							_ioService;
 			boost::asio::system_timer				_scheduleTimer {_ioService};
+			boost::asio::steady_timer				_watchDebounceTimer {_ioService};
 			const bool								_skipDuplicateRecordingMBID {};
 			Events									_events;
 			std::chrono::system_clock::time_point	_lastScanInProgressEmit {};
 			Database::Session						_dbSession;
-			std::unique_ptr<MetaData::IParser>		_metadataParser;
+			const MetaData::ParserReadStyle			_parserReadStyle;
+			const std::size_t						_parserThreadCount;
+			const std::size_t						_writeBatchSize;
+			const std::chrono::milliseconds			_writeBatchMaxDuration;
+			ScanCache								_scanCache;
+			const bool								_watchMediaDirectory;
+			const std::chrono::seconds				_watchDebounceDelay;
+			std::unique_ptr<MediaDirectoryWatcher>	_mediaDirectoryWatcher;
+			std::set<std::filesystem::path>			_changedPaths; // waiting for the debounce delay
 
 			mutable std::shared_mutex			_statusMutex;
 			State								_curState {State::NotScheduled};
@@ -117,6 +166,7 @@ namespace Scanner
 			std::vector<std::filesystem::path>		_fileExtensions;
 			std::filesystem::path					_mediaDirectory;
 			Database::ScanSettings::RecommendationEngineType _recommendationServiceType;
+			std::set<std::string>					_clusterTypeNames;
 	};
 } // Scanner
 
@@ -22,6 +22,11 @@
 #include <Wt/WDateTime.h>
 #include <Wt/WSignal.h>
 
+#include <vector>
+
+#include "services/database/ArtistId.hpp"
+#include "services/database/ReleaseId.hpp"
+#include "services/database/TrackId.hpp"
 #include "ScannerStats.hpp"
 
 namespace Scanner
@@ -40,6 +45,11 @@ namespace Scanner
 
 		// Called after a schedule
 		Wt::Signal<Wt::WDateTime>	scanScheduled;
+
+		// Called from the scan thread, as soon as objects are removed from the database
+		Wt::Signal<std::vector<Database::TrackId>>		tracksRemoved;
+		Wt::Signal<std::vector<Database::ReleaseId>>	releasesRemoved;
+		Wt::Signal<std::vector<Database::ArtistId>>		artistsRemoved;
 	};
 
 } // ns Scanner
@@ -59,8 +59,8 @@ namespace Scanner
 
 	enum class ScanProgressStep : unsigned
 	{
-		ChekingForMissingFiles = 0,
-		DiscoveringFiles,
+		DiscoveringFiles = 0,
+		ChekingForMissingFiles,
 		ScanningFiles,
 		FetchingTrackFeatures,
 		ReloadingSimilarityEngine,
@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <gtest/gtest.h>
+
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+#include "AcousticBrainzFeaturesFetcher.hpp"
+
+using namespace AcousticBrainz;
+
+namespace
+{
+	// Local stand-in for the AcousticBrainz API, serving one request per connection
+	class HttpServer
+	{
+		public:
+			struct Response
+			{
+				unsigned		status {200};
+				std::string		body;
+				std::vector<std::pair<std::string, std::string>> headers;
+			};
+			// Called from the server thread
+			using RequestHandler = std::function<Response(const std::string& target)>;
+
+			HttpServer(RequestHandler requestHandler, std::chrono::milliseconds responseDelay = std::chrono::milliseconds {})
+			: _requestHandler {std::move(requestHandler)}
+			, _responseDelay {responseDelay}
+			{
+				accept();
+				_thread = std::thread {[this] { _ioContext.run(); }};
+			}
+
+			~HttpServer()
+			{
+				_ioContext.stop();
+				_thread.join();
+			}
+
+			HttpServer(const HttpServer&) = delete;
+			HttpServer(HttpServer&&) = delete;
+			HttpServer& operator=(const HttpServer&) = delete;
+			HttpServer& operator=(HttpServer&&) = delete;
+
+			std::string getBaseUrl() const
+			{
+				return "http://127.0.0.1:" + std::to_string(_acceptor.local_endpoint().port());
+			}
+
+			std::vector<std::string> getRequestTargets() const
+			{
+				std::scoped_lock lock {_mutex};
+				return _requestTargets;
+			}
+
+			std::vector<std::chrono::steady_clock::time_point> getRequestTimes() const
+			{
+				std::scoped_lock lock {_mutex};
+				return _requestTimes;
+			}
+
+			std::size_t getMaxOngoingRequestCount() const { return _maxOngoingRequestCount; }
+
+		private:
+			struct Connection
+			{
+				Connection(boost::asio::ip::tcp::socket socket, boost::asio::io_context& ioContext)
+				: socket {std::move(socket)}
+				, timer {ioContext}
+				{}
+
+				boost::asio::ip::tcp::socket	socket;
+				boost::asio::steady_timer		timer;
+				boost::asio::streambuf			request;
+				std::string						response;
+			};
+
+			void accept()
+			{
+				_acceptor.async_accept([this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket)
+				{
+					if (ec)
+						return;
+
+					handleConnection(std::make_shared<Connection>(std::move(socket), _ioContext));
+					accept();
+				});
+			}
+
+			void handleConnection(std::shared_ptr<Connection> connection)
+			{
+				boost::asio::async_read_until(connection->socket, connection->request, "\r\n\r\n", [this, connection](const boost::system::error_code& ec, std::size_t)
+				{
+					if (ec)
+						return;
+
+					std::istream is {&connection->request};
+					std::string method;
+					std::string target;
+					is >> method >> target;
+
+					{
+						std::scoped_lock lock {_mutex};
+						_requestTargets.push_back(target);
+						_requestTimes.push_back(std::chrono::steady_clock::now());
+					}
+					_maxOngoingRequestCount = std::max(_maxOngoingRequestCount.load(), ++_ongoingRequestCount);
+
+					const Response response {_requestHandler(target)};
+
+					std::ostringstream oss;
+					oss << "HTTP/1.1 " << response.status << " Stand-in\r\n";
+					oss << "Content-Length: " << response.body.size() << "\r\n";
+					oss << "Connection: close\r\n";
+					for (const auto& [name, value] : response.headers)
+						oss << name << ": " << value << "\r\n";
+					oss << "\r\n" << response.body;
+					connection->response = oss.str();
+
+					connection->timer.expires_after(_responseDelay);
+					connection->timer.async_wait([this, connection](const boost::system::error_code&)
+					{
+						// the client cannot send a new request on this slot before getting the response
+						_ongoingRequestCount--;
+
+						boost::asio::async_write(connection->socket, boost::asio::buffer(connection->response), [connection](const boost::system::error_code&, std::size_t)
+						{
+							boost::system::error_code ignored;
+							connection->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+						});
+					});
+				});
+			}
+
+			const RequestHandler				_requestHandler;
+			const std::chrono::milliseconds		_responseDelay;
+			boost::asio::io_context				_ioContext;
+			boost::asio::ip::tcp::acceptor		_acceptor {_ioContext, boost::asio::ip::tcp::endpoint {boost::asio::ip::address_v4::loopback(), 0}};
+			std::thread							_thread;
+
+			mutable std::mutex					_mutex;
+			std::vector<std::string>			_requestTargets;
+			std::vector<std::chrono::steady_clock::time_point> _requestTimes;
+			std::atomic<std::size_t>			_ongoingRequestCount {};
+			std::atomic<std::size_t>			_maxOngoingRequestCount {};
+	};
+
+	constexpr std::string_view bulkRequestPrefix {"/api/v1/low-level?recording_ids="};
+	const std::string lowLevelData {R"({"lowlevel": {"average_loudness": 0.5}})"};
+
+	std::vector<UUID>
+	createRecordingMBIDs(std::size_t count)
+	{
+		std::vector<UUID> res;
+
+		for (std::size_t i {}; i < count; ++i)
+		{
+			std::ostringstream oss;
+			oss << "00000000-0000-0000-0000-" << std::setw(12) << std::setfill('0') << i;
+			res.push_back(*UUID::fromString(oss.str()));
+		}
+
+		return res;
+	}
+
+	bool
+	isBulkRequest(const std::string& target)
+	{
+		return target.compare(0, bulkRequestPrefix.size(), bulkRequestPrefix) == 0;
+	}
+
+	std::vector<std::string>
+	getBulkRequestRecordingMBIDs(const std::string& target)
+	{
+		std::vector<std::string> res;
+
+		std::istringstream iss {target.substr(bulkRequestPrefix.size())};
+		std::string recordingMBID;
+		while (std::getline(iss, recordingMBID, ';'))
+			res.push_back(recordingMBID);
+
+		return res;
+	}
+
+	// "/api/v1/<mbid>/low-level"
+	std::string
+	getSingleRequestRecordingMBID(const std::string& target)
+	{
+		constexpr std::string_view prefix {"/api/v1/"};
+		return target.substr(prefix.size(), target.find('/', prefix.size()) - prefix.size());
+	}
+
+	std::string
+	createBulkResponseBody(const std::vector<std::string>& recordingMBIDs)
+	{
+		std::string body {"{"};
+		for (const std::string& recordingMBID : recordingMBIDs)
+		{
+			if (body.size() > 1)
+				body += ", ";
+			body += "\"" + recordingMBID + "\": {\"0\": " + lowLevelData + "}";
+		}
+		body += "}";
+
+		return body;
+	}
+
+	bool
+	isEvenRecording(const std::string& recordingMBID)
+	{
+		return (recordingMBID.back() - '0') % 2 == 0;
+	}
+
+	// Results indexed by recording MBID
+	std::unordered_map<std::string, std::string>
+	fetchFeatures(FeaturesFetcher& fetcher, const std::vector<UUID>& recordingMBIDs)
+	{
+		std::unordered_map<std::string, std::string> res;
+
+		fetcher.pushRequests(recordingMBIDs);
+
+		const auto deadline {std::chrono::steady_clock::now() + std::chrono::seconds {30}};
+		while (fetcher.getPendingCount() > 0 && std::chrono::steady_clock::now() < deadline)
+		{
+			fetcher.waitForResults(std::chrono::milliseconds {100});
+			for (FeaturesFetcher::Result& result : fetcher.popResults())
+			{
+				[[maybe_unused]] const auto [it, inserted] {res.emplace(std::string {result.recordingMBID.getAsString()}, std::move(result.data))};
+				EXPECT_TRUE(inserted) << "Duplicate result for recording " << it->first;
+			}
+		}
+		EXPECT_EQ(fetcher.getPendingCount(), 0);
+
+		return res;
+	}
+}
+
+TEST(AcousticBrainzFeaturesFetcher, bulkRequests)
+{
+	HttpServer server {[](const std::string& target)
+	{
+		return HttpServer::Response {200, createBulkResponseBody(getBulkRequestRecordingMBIDs(target)), {}};
+	}, std::chrono::milliseconds {100}};
+
+	const std::vector<UUID> recordingMBIDs {createRecordingMBIDs(60)};
+	const auto results {[&]
+	{
+		FeaturesFetcher fetcher {server.getBaseUrl(), 2};
+		return fetchFeatures(fetcher, recordingMBIDs);
+	}()};
+
+	ASSERT_EQ(results.size(), recordingMBIDs.size());
+	for (const UUID& recordingMBID : recordingMBIDs)
+	{
+		const auto itResult {results.find(std::string {recordingMBID.getAsString()})};
+		ASSERT_NE(itResult, std::cend(results));
+		EXPECT_NE(itResult->second.find("average_loudness"), std::string::npos);
+	}
+
+	// 25 recordings per bulk request, one request at a time per client
+	const std::vector<std::string> targets {server.getRequestTargets()};
+	ASSERT_EQ(targets.size(), 3);
+	for (const std::string& target : targets)
+		EXPECT_TRUE(isBulkRequest(target));
+	EXPECT_EQ(server.getMaxOngoingRequestCount(), 2);
+}
+
+TEST(AcousticBrainzFeaturesFetcher, partialBulkResponse)
+{
+	HttpServer server {[](const std::string& target)
+	{
+		std::vector<std::string> recordingMBIDs {getBulkRequestRecordingMBIDs(target)};
+		recordingMBIDs.erase(std::remove_if(std::begin(recordingMBIDs), std::end(recordingMBIDs), [](const std::string& recordingMBID) { return !isEvenRecording(recordingMBID); }), std::end(recordingMBIDs));
+
+		return HttpServer::Response {200, createBulkResponseBody(recordingMBIDs), {}};
+	}};
+
+	const std::vector<UUID> recordingMBIDs {createRecordingMBIDs(10)};
+	const auto results {[&]
+	{
+		FeaturesFetcher fetcher {server.getBaseUrl(), 1};
+		return fetchFeatures(fetcher, recordingMBIDs);
+	}()};
+
+	// Missing recordings are reported without data, and are not requested again
+	ASSERT_EQ(results.size(), recordingMBIDs.size());
+	for (const auto& [recordingMBID, data] : results)
+		EXPECT_EQ(data.empty(), !isEvenRecording(recordingMBID)) << "Recording " << recordingMBID;
+
+	EXPECT_EQ(server.getRequestTargets().size(), 1);
+}
+
+TEST(AcousticBrainzFeaturesFetcher, bulkFailureFallback)
+{
+	HttpServer server {[](const std::string& target)
+	{
+		if (isBulkRequest(target))
+			return HttpServer::Response {500, "Internal error", {}};
+
+		if (!isEvenRecording(getSingleRequestRecordingMBID(target)))
+			return HttpServer::Response {404, "Not found", {}};
+
+		return HttpServer::Response {200, lowLevelData, {}};
+	}};
+
+	const std::vector<UUID> recordingMBIDs {createRecordingMBIDs(6)};
+	const auto results {[&]
+	{
+		FeaturesFetcher fetcher {server.getBaseUrl(), 2};
+		return fetchFeatures(fetcher, recordingMBIDs);
+	}()};
+
+	// Single request failures are reported without data
+	ASSERT_EQ(results.size(), recordingMBIDs.size());
+	for (const auto& [recordingMBID, data] : results)
+	{
+		if (isEvenRecording(recordingMBID))
+			EXPECT_EQ(data, lowLevelData);
+		else
+			EXPECT_TRUE(data.empty()) << "Recording " << recordingMBID;
+	}
+
+	const std::vector<std::string> targets {server.getRequestTargets()};
+	ASSERT_EQ(targets.size(), 1 + recordingMBIDs.size());
+	EXPECT_TRUE(isBulkRequest(targets.front()));
+	for (auto itTarget {std::next(std::cbegin(targets))}; itTarget != std::cend(targets); ++itTarget)
+		EXPECT_FALSE(isBulkRequest(*itTarget));
+}
+
+TEST(AcousticBrainzFeaturesFetcher, invalidBulkResponse)
+{
+	HttpServer server {[](const std::string& target)
+	{
+		if (isBulkRequest(target))
+			return HttpServer::Response {200, "{not json", {}};
+
+		return HttpServer::Response {200, lowLevelData, {}};
+	}};
+
+	const std::vector<UUID> recordingMBIDs {createRecordingMBIDs(3)};
+	const auto results {[&]
+	{
+		FeaturesFetcher fetcher {server.getBaseUrl(), 1};
+		return fetchFeatures(fetcher, recordingMBIDs);
+	}()};
+
+	ASSERT_EQ(results.size(), recordingMBIDs.size());
+	for (const auto& [recordingMBID, data] : results)
+		EXPECT_EQ(data, lowLevelData);
+
+	EXPECT_EQ(server.getRequestTargets().size(), 1 + recordingMBIDs.size());
+}
+
+TEST(AcousticBrainzFeaturesFetcher, rateLimited)
+{
+	std::atomic<std::size_t> requestCount {};
+	HttpServer server {[&](const std::string& target)
+	{
+		if (requestCount++ == 0)
+			return HttpServer::Response {429, "Too many requests", {{"X-RateLimit-Reset-In", "1"}}};
+
+		return HttpServer::Response {200, createBulkResponseBody(getBulkRequestRecordingMBIDs(target)), {}};
+	}};
+
+	const std::vector<UUID> recordingMBIDs {createRecordingMBIDs(5)};
+	const auto startTime {std::chrono::steady_clock::now()};
+	const auto results {[&]
+	{
+		FeaturesFetcher fetcher {server.getBaseUrl(), 1};
+		return fetchFeatures(fetcher, recordingMBIDs);
+	}()};
+
+	// The same request is sent again once the rate limit is reset
+	ASSERT_EQ(results.size(), recordingMBIDs.size());
+	for (const auto& [recordingMBID, data] : results)
+		EXPECT_FALSE(data.empty()) << "Recording " << recordingMBID;
+
+	const std::vector<std::string> targets {server.getRequestTargets()};
+	ASSERT_EQ(targets.size(), 2);
+	EXPECT_EQ(targets[0], targets[1]);
+	EXPECT_GE(std::chrono::steady_clock::now() - startTime, std::chrono::seconds {1});
+}
+
+TEST(AcousticBrainzFeaturesFetcher, rateLimitSharedByClients)
+{
+	std::atomic<std::size_t> requestCount {};
+	HttpServer server {[&](const std::string& target)
+	{
+		if (requestCount++ == 0)
+			return HttpServer::Response {429, "Too many requests", {{"X-RateLimit-Reset-In", "1"}}};
+
+		return HttpServer::Response {200, createBulkResponseBody(getBulkRequestRecordingMBIDs(target)), {}};
+	}, std::chrono::milliseconds {300}};
+
+	const std::vector<UUID> recordingMBIDs {createRecordingMBIDs(75)};
+	const auto results {[&]
+	{
+		FeaturesFetcher fetcher {server.getBaseUrl(), 2};
+		return fetchFeatures(fetcher, recordingMBIDs);
+	}()};
+
+	ASSERT_EQ(results.size(), recordingMBIDs.size());
+	for (const auto& [recordingMBID, data] : results)
+		EXPECT_FALSE(data.empty()) << "Recording " << recordingMBID;
+
+	// 3 bulk requests, the rate limited one being sent twice
+	// Once the first response is received, no client sends anything until the rate limit is reset
+	const std::vector<std::chrono::steady_clock::time_point> requestTimes {server.getRequestTimes()};
+	ASSERT_EQ(requestTimes.size(), 4);
+	for (std::size_t i {2}; i < requestTimes.size(); ++i)
+		EXPECT_GE(requestTimes[i] - requestTimes.front(), std::chrono::seconds {1}) << "Request " << i;
+}
+
+int main(int argc, char **argv)
+{
+	// log to stdout
+	Service<Logger> logger {std::make_unique<StreamLogger>(std::cout, EnumSet<Severity> {Severity::FATAL, Severity::ERROR})};
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -47,6 +47,7 @@ variance(const std::vector<T>& vec)
 
 DataNormalizer::DataNormalizer(std::size_t inputDimCount)
 : _inputDimCount{inputDimCount}
+, _minmax(inputDimCount)
 {
 }
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#define SOM_KERNELS_USE_SIMD
+#include <immintrin.h>
+#endif
+
+// Computation kernels working on the dimension rows of a RefVectorStorage
+// Processing aligned and padded rows is faster, but any position and count can be used
+namespace SOM::Kernels
+{
+#ifdef SOM_KERNELS_USE_SIMD
+	namespace details
+	{
+		template <typename T>
+		struct Simd;
+
+#if defined(__AVX__)
+		template <>
+		struct Simd<double>
+		{
+			using Register = __m256d;
+			static constexpr std::size_t size {4};
+
+			static Register load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+			static void store(double* ptr, Register value) { _mm256_storeu_pd(ptr, value); }
+			static Register set(double value) { return _mm256_set1_pd(value); }
+			static Register add(Register a, Register b) { return _mm256_add_pd(a, b); }
+			static Register sub(Register a, Register b) { return _mm256_sub_pd(a, b); }
+			static Register mul(Register a, Register b) { return _mm256_mul_pd(a, b); }
+		};
+
+		template <>
+		struct Simd<float>
+		{
+			using Register = __m256;
+			static constexpr std::size_t size {8};
+
+			static Register load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+			static void store(float* ptr, Register value) { _mm256_storeu_ps(ptr, value); }
+			static Register set(float value) { return _mm256_set1_ps(value); }
+			static Register add(Register a, Register b) { return _mm256_add_ps(a, b); }
+			static Register sub(Register a, Register b) { return _mm256_sub_ps(a, b); }
+			static Register mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+		};
+#else
+		template <>
+		struct Simd<double>
+		{
+			using Register = __m128d;
+			static constexpr std::size_t size {2};
+
+			static Register load(const double* ptr) { return _mm_loadu_pd(ptr); }
+			static void store(double* ptr, Register value) { _mm_storeu_pd(ptr, value); }
+			static Register set(double value) { return _mm_set1_pd(value); }
+			static Register add(Register a, Register b) { return _mm_add_pd(a, b); }
+			static Register sub(Register a, Register b) { return _mm_sub_pd(a, b); }
+			static Register mul(Register a, Register b) { return _mm_mul_pd(a, b); }
+		};
+
+		template <>
+		struct Simd<float>
+		{
+			using Register = __m128;
+			static constexpr std::size_t size {4};
+
+			static Register load(const float* ptr) { return _mm_loadu_ps(ptr); }
+			static void store(float* ptr, Register value) { _mm_storeu_ps(ptr, value); }
+			static Register set(float value) { return _mm_set1_ps(value); }
+			static Register add(Register a, Register b) { return _mm_add_ps(a, b); }
+			static Register sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+			static Register mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+		};
+#endif
+	} // namespace details
+#endif // SOM_KERNELS_USE_SIMD
+
+	// distances[i] += weight * (values[i] - input)^2
+	template <typename T>
+	void
+	accumulateWeightedSquareDistances(const T* values, T input, T weight, T* distances, std::size_t count)
+	{
+		std::size_t i {};
+#ifdef SOM_KERNELS_USE_SIMD
+		using Simd = details::Simd<T>;
+
+		const auto inputs {Simd::set(input)};
+		const auto weights {Simd::set(weight)};
+		for (; i + Simd::size <= count; i += Simd::size)
+		{
+			const auto diff {Simd::sub(Simd::load(values + i), inputs)};
+			Simd::store(distances + i, Simd::add(Simd::load(distances + i), Simd::mul(Simd::mul(diff, diff), weights)));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const T diff {values[i] - input};
+			distances[i] += diff * diff * weight;
+		}
+	}
+
+	// values[i] += factors[i] * (input - values[i])
+	template <typename T>
+	void
+	moveTowards(T* values, T input, const T* factors, std::size_t count)
+	{
+		std::size_t i {};
+#ifdef SOM_KERNELS_USE_SIMD
+		using Simd = details::Simd<T>;
+
+		const auto inputs {Simd::set(input)};
+		for (; i + Simd::size <= count; i += Simd::size)
+		{
+			const auto current {Simd::load(values + i)};
+			Simd::store(values + i, Simd::add(current, Simd::mul(Simd::load(factors + i), Simd::sub(inputs, current))));
+		}
+#endif
+		for (; i < count; ++i)
+			values[i] += factors[i] * (input - values[i]);
+	}
+
+	// sum of a[i] * b[i]
+	template <typename T>
+	T
+	dotProduct(const T* a, const T* b, std::size_t count)
+	{
+		std::size_t i {};
+		T res {};
+#ifdef SOM_KERNELS_USE_SIMD
+		using Simd = details::Simd<T>;
+
+		auto sums {Simd::set(0)};
+		for (; i + Simd::size <= count; i += Simd::size)
+			sums = Simd::add(sums, Simd::mul(Simd::load(a + i), Simd::load(b + i)));
+
+		T partialSums[Simd::size];
+		Simd::store(partialSums, sums);
+		for (const T partialSum : partialSums)
+			res += partialSum;
+#endif
+		for (; i < count; ++i)
+			res += a[i] * b[i];
+
+		return res;
+	}
+} // namespace SOM::Kernels
@@ -20,14 +20,20 @@
 #include "som/Network.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <exception>
+#include <limits>
+#include <mutex>
 #include <random>
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 
 #include "utils/Logger.hpp"
 #include "utils/Random.hpp"
+#include "Kernels.hpp"
 
 namespace SOM
 {
@@ -78,26 +84,116 @@ defaultNeighbourhoodFunc(Norm norm, const Network::CurrentIteration& iteration)
 	return exp(-norm / (2 * sigma * sigma));
 }
 
-Network::Network(Coordinate width, Coordinate height, std::size_t inputDimCount)
+// Calls func(begin, end) on consecutive blocks of [0, count), using several threads
+// The stop callback is only called from the calling thread, returns false if a stop has been requested
+// The first exception thrown by func stops the processing and is rethrown once all the threads are joined
+static
+bool
+processBlocksInParallel(std::size_t count, std::size_t threadCount, std::function<void(std::size_t, std::size_t)> func, const Network::RequestStopCallback& requestStopCallback)
+{
+	constexpr std::size_t blockSize {32};
+
+	std::atomic<std::size_t> nextBlockBegin {};
+	std::atomic<bool> stopRequested {};
+	std::atomic<bool> failed {};
+	std::mutex exceptionMutex;
+	std::exception_ptr exception;
+
+	auto processBlocks {[&](bool canRequestStop)
+	{
+		try
+		{
+			while (!stopRequested && !failed)
+			{
+				if (canRequestStop && requestStopCallback && requestStopCallback())
+				{
+					stopRequested = true;
+					break;
+				}
+
+				const std::size_t begin {nextBlockBegin.fetch_add(blockSize)};
+				if (begin >= count)
+					break;
+
+				func(begin, std::min(begin + blockSize, count));
+			}
+		}
+		catch (...)
+		{
+			std::scoped_lock lock {exceptionMutex};
+			if (!exception)
+				exception = std::current_exception();
+			failed = true;
+		}
+	}};
+
+	std::vector<std::thread> threads;
+	for (std::size_t i {1}; i < threadCount; ++i)
+		threads.emplace_back(processBlocks, false);
+
+	processBlocks(true);
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	if (exception)
+		std::rethrow_exception(exception);
+
+	return !stopRequested;
+}
+
+static
+Random::RandGenerator
+createRandGenerator(std::optional<std::uint_fast32_t> seed)
+{
+	return Random::createSeededGenerator(seed ? *seed : static_cast<std::uint_fast32_t>(Random::getRandGenerator()()));
+}
+
+Network::Network(Coordinate width, Coordinate height, std::size_t inputDimCount, std::optional<std::uint_fast32_t> seed)
 :
+_randGenerator {createRandGenerator(seed)},
 _inputDimCount {inputDimCount},
 _weights {inputDimCount, static_cast<InputVector::value_type>(1)},
-_refVectors {width, height, _inputDimCount},
+_refVectors {RefVectorStorage<double> {width, height, _inputDimCount}},
 _distanceFunc {euclidianSquareDistance},
 _learningFactorFunc {defaultLearningFactor},
 _neighbourhoodFunc {defaultNeighbourhoodFunc}
 {
 	// init each vector with a random normalized value
-	for (Coordinate y {}; y < _refVectors.getHeight(); ++y)
+	RefVectorStorage<double>& refVectors {std::get<RefVectorStorage<double>>(_refVectors)};
+
+	std::uniform_real_distribution<InputVector::value_type> dist {0, 1};
+	for (std::size_t index {}; index < refVectors.getCount(); ++index)
 	{
-		for (Coordinate x {}; x < _refVectors.getWidth(); ++x)
-		{
-			for (InputVector::value_type& val : _refVectors.get({x,y}))
-				val = Random::getRealRandom<InputVector::value_type>(0, 1);
-		}
+		for (std::size_t dimension {}; dimension < _inputDimCount; ++dimension)
+			refVectors.getDimensionValues(dimension)[index] = dist(_randGenerator);
 	}
 }
 
+void
+Network::setPrecision(Precision precision)
+{
+	if (precision == getPrecision())
+		return;
+
+	switch (precision)
+	{
+		case Precision::Double:
+			_refVectors = RefVectorStorage<double> {std::get<RefVectorStorage<float>>(_refVectors)};
+			break;
+
+		case Precision::Float:
+			_refVectors = RefVectorStorage<float> {std::get<RefVectorStorage<double>>(_refVectors)};
+			break;
+	}
+}
+
+Network::Precision
+Network::getPrecision() const
+{
+	return std::holds_alternative<RefVectorStorage<float>>(_refVectors) ? Precision::Float : Precision::Double;
+}
+
 void
 Network::setDataWeights(const InputVector& weights)
 {
@@ -106,32 +202,68 @@ Network::setDataWeights(const InputVector& weights)
 	_weights = weights;
 }
 
+void
+Network::setDistanceFunc(DistanceFunc distanceFunc)
+{
+	_distanceFunc = std::move(distanceFunc);
+	_hasCustomDistanceFunc = true;
+}
+
+void
+Network::setLearningFactorFunc(LearningFactorFunc learningFactorFunc)
+{
+	_learningFactorFunc = std::move(learningFactorFunc);
+}
+
+void
+Network::setNeighbourhoodFunc(NeighbourhoodFunc neighbourhoodFunc)
+{
+	_neighbourhoodFunc = std::move(neighbourhoodFunc);
+}
+
 void
 Network::setRefVector(const Position& position, const InputVector& data)
 {
 	checkSameDimensions(data, _inputDimCount);
 
-	_refVectors[position] = data;
+	std::visit([&](auto& refVectors) { refVectors.set(position, data); }, _refVectors);
 }
 
 InputVector::Distance
 Network::getRefVectorsDistance(const Position& position1, const Position& position2) const
 {
-	return _distanceFunc(_refVectors.get(position1), _refVectors.get(position2), _weights);
+	if (_hasCustomDistanceFunc)
+		return _distanceFunc(getRefVector(position1), getRefVector(position2), _weights);
+
+	return std::visit([&](const auto& refVectors)
+	{
+		const std::size_t index1 {refVectors.getIndex(position1)};
+		const std::size_t index2 {refVectors.getIndex(position2)};
+
+		InputVector::Distance res {};
+		for (std::size_t dimension {}; dimension < _inputDimCount; ++dimension)
+		{
+			const auto* values {refVectors.getDimensionValues(dimension)};
+			const InputVector::Distance diff {static_cast<InputVector::Distance>(values[index1]) - values[index2]};
+			res += diff * diff * _weights[dimension];
+		}
+
+		return res;
+	}, _refVectors);
 }
 
 InputVector::Distance
 Network::computeRefVectorsDistanceMean() const
 {
 	std::vector<InputVector::Distance> values;
-	values.reserve(2 * _refVectors.getHeight()*_refVectors.getWidth() - _refVectors.getWidth() - _refVectors.getHeight());
-	for (Coordinate y {}; y < _refVectors.getHeight(); ++y)
+	values.reserve(2 * getHeight()*getWidth() - getWidth() - getHeight());
+	for (Coordinate y {}; y < getHeight(); ++y)
 	{
-		for (Coordinate x {}; x < _refVectors.getWidth(); ++x)
+		for (Coordinate x {}; x < getWidth(); ++x)
 		{
-			if (x != _refVectors.getWidth() - 1)
+			if (x != getWidth() - 1)
 				values.emplace_back(getRefVectorsDistance( {x, y}, {x + 1, y}));
-			if (y != _refVectors.getHeight() - 1)
+			if (y != getHeight() - 1)
 				values.emplace_back(getRefVectorsDistance( {x, y}, {x, y + 1}));
 		}
 	}
@@ -143,14 +275,14 @@ double
 Network::computeRefVectorsDistanceMedian() const
 {
 	std::vector<InputVector::Distance> values;
-	values.reserve(2*_refVectors.getHeight()*_refVectors.getWidth() - _refVectors.getWidth() - _refVectors.getHeight());
-	for (Coordinate y {}; y < _refVectors.getHeight(); ++y)
+	values.reserve(2*getHeight()*getWidth() - getWidth() - getHeight());
+	for (Coordinate y {}; y < getHeight(); ++y)
 	{
-		for (Coordinate x {}; x < _refVectors.getWidth(); ++x)
+		for (Coordinate x {}; x < getWidth(); ++x)
 		{
-			if (x != _refVectors.getWidth() - 1)
+			if (x != getWidth() - 1)
 				values.emplace_back(getRefVectorsDistance( {x, y}, {x + 1, y}));
-			if (y != _refVectors.getHeight() - 1)
+			if (y != getHeight() - 1)
 				values.emplace_back(getRefVectorsDistance( {x, y}, {x, y + 1}));
 		}
 	}
@@ -163,13 +295,13 @@ Network::computeRefVectorsDistanceMedian() const
 void
 Network::dump(std::ostream& os) const
 {
-	os << "Width: " << _refVectors.getWidth() << ", Height: " << _refVectors.getHeight() << std::endl;;
+	os << "Width: " << getWidth() << ", Height: " << getHeight() << std::endl;;
 
-	for (Coordinate y {}; y < _refVectors.getHeight(); ++y)
+	for (Coordinate y {}; y < getHeight(); ++y)
 	{
-		for (Coordinate x {}; x < _refVectors.getWidth(); ++x)
+		for (Coordinate x {}; x < getWidth(); ++x)
 		{
-			os << _refVectors.get({x, y}) << " ";
+			os << getRefVector({x, y}) << " ";
 		}
 
 		os << std::endl;
@@ -177,24 +309,60 @@ Network::dump(std::ostream& os) const
 	os << std::endl;
 }
 
+template <typename T>
+Network::ClosestRefVector
+Network::getClosestRefVector(const RefVectorStorage<T>& refVectors, const InputVector& data) const
+{
+	checkSameDimensions(data, _inputDimCount);
+
+	if (_hasCustomDistanceFunc)
+	{
+		ClosestRefVector res {0, std::numeric_limits<InputVector::Distance>::max()};
+		for (std::size_t index {}; index < refVectors.getCount(); ++index)
+		{
+			const InputVector::Distance distance {_distanceFunc(refVectors.get(refVectors.getPosition(index)), data, _weights)};
+			if (distance < res.distance)
+				res = {index, distance};
+		}
+
+		return res;
+	}
+
+	// Computes the distances to all the ref vectors at once, dimension by dimension
+	thread_local typename RefVectorStorage<T>::Buffer distances;
+	distances.assign(refVectors.getStride(), 0);
+
+	auto itData {data.cbegin()};
+	auto itWeight {_weights.cbegin()};
+	for (std::size_t dimension {}; dimension < _inputDimCount; ++dimension)
+		Kernels::accumulateWeightedSquareDistances(refVectors.getDimensionValues(dimension), static_cast<T>(*itData++), static_cast<T>(*itWeight++), distances.data(), distances.size());
+
+	// padding values are ignored
+	const auto itMin {std::min_element(std::cbegin(distances), std::cbegin(distances) + refVectors.getCount())};
+	return {static_cast<std::size_t>(std::distance(std::cbegin(distances), itMin)), *itMin};
+}
+
+Network::ClosestRefVector
+Network::getClosestRefVector(const InputVector& data) const
+{
+	return std::visit([&](const auto& refVectors) { return getClosestRefVector(refVectors, data); }, _refVectors);
+}
+
 Position
 Network::getClosestRefVectorPosition(const InputVector& data) const
 {
-	return _refVectors.getPositionMinElement([&](const auto& a, const auto& b)
-			{
-				return (_distanceFunc(a, data, _weights) < _distanceFunc(b, data, _weights));
-			});
+	const std::size_t index {getClosestRefVector(data).index};
+	return {static_cast<Coordinate>(index % getWidth()), static_cast<Coordinate>(index / getWidth())};
 }
 
 std::optional<Position>
 Network::getClosestRefVectorPosition(const InputVector& data, InputVector::Distance maxDistance) const
 {
-	std::optional<Position> position {getClosestRefVectorPosition(data)};
-
-	if (_distanceFunc(data, _refVectors.get(*position), _weights) > maxDistance)
-		position.reset();
+	const ClosestRefVector closestRefVector {getClosestRefVector(data)};
+	if (closestRefVector.distance > maxDistance)
+		return std::nullopt;
 
-	return position;
+	return Position {static_cast<Coordinate>(closestRefVector.index % getWidth()), static_cast<Coordinate>(closestRefVector.index / getWidth())};
 }
 
 std::optional<Position>
@@ -205,11 +373,11 @@ Network::getClosestRefVectorPosition(const std::vector<Position>& refVectorsPosi
 	{
 		if (refVectorPosition.y > 0)
 			neighboursPosition.insert({ refVectorPosition.x, refVectorPosition.y - 1 });
-		if (refVectorPosition.y < _refVectors.getHeight() - 1)
+		if (refVectorPosition.y < getHeight() - 1)
 			neighboursPosition.insert({ refVectorPosition.x, refVectorPosition.y + 1 });
 		if (refVectorPosition.x > 0)
 			neighboursPosition.insert({ refVectorPosition.x - 1, refVectorPosition.y });
-		if (refVectorPosition.x < _refVectors.getWidth() - 1)
+		if (refVectorPosition.x < getWidth() - 1)
 			neighboursPosition.insert({ refVectorPosition.x + 1, refVectorPosition.y });
 	}
 
@@ -262,35 +430,105 @@ computePositionNorm(const Position& c1, const Position& c2)
 	return std::sqrt((c1.x - c2.x) * (c1.x - c2.x) + (c1.y - c2.y) * (c1.y - c2.y));
 }
 
+std::optional<Coordinate>
+Network::computeNeighbourhoodRadius(const CurrentIteration& iteration) const
+{
+	const Coordinate maxRadius {std::max(getWidth(), getHeight())};
+	if (_neighbourhoodThreshold <= 0)
+		return maxRadius;
+
+	std::optional<Coordinate> radius;
+	for (Coordinate candidate {}; candidate <= maxRadius; ++candidate)
+	{
+		if (_neighbourhoodFunc(candidate, iteration) < _neighbourhoodThreshold)
+			break;
+
+		radius = candidate;
+	}
+
+	return radius;
+}
+
+// Only the ref vectors in the square centered on the closest ref vector are processed
+template <typename T>
 void
-Network::updateRefVectors(const Position& closestRefVectorPosition, const InputVector& input, LearningFactor learningFactor, const CurrentIteration& iteration)
+Network::updateRefVectors(RefVectorStorage<T>& refVectors, const Position& closestRefVectorPosition, const InputVector& input, LearningFactor learningFactor, const CurrentIteration& iteration, Coordinate neighbourhoodRadius, typename RefVectorStorage<T>::Buffer& factors)
 {
-	for (Coordinate y {}; y < _refVectors.getHeight(); ++y)
+	const Coordinate xBegin {closestRefVectorPosition.x > neighbourhoodRadius ? closestRefVectorPosition.x - neighbourhoodRadius : 0};
+	const Coordinate xEnd {std::min(closestRefVectorPosition.x + neighbourhoodRadius + 1, refVectors.getWidth())};
+	const Coordinate yBegin {closestRefVectorPosition.y > neighbourhoodRadius ? closestRefVectorPosition.y - neighbourhoodRadius : 0};
+	const Coordinate yEnd {std::min(closestRefVectorPosition.y + neighbourhoodRadius + 1, refVectors.getHeight())};
+
+	const std::size_t rowSize {static_cast<std::size_t>(xEnd - xBegin)};
+
+	factors.resize(rowSize * (yEnd - yBegin));
+	auto itFactor {std::begin(factors)};
+	for (Coordinate y {yBegin}; y < yEnd; ++y)
 	{
-		for (Coordinate x {}; x < _refVectors.getWidth(); ++x)
+		for (Coordinate x {xBegin}; x < xEnd; ++x)
 		{
-			InputVector& refVector {_refVectors.get({x, y})};
+			const InputVector::value_type neighbourhood {_neighbourhoodFunc(computePositionNorm({x, y}, closestRefVectorPosition), iteration)};
+			*itFactor++ = (neighbourhood < _neighbourhoodThreshold) ? 0 : static_cast<T>(learningFactor * neighbourhood);
+		}
+	}
 
-			const Norm norm {computePositionNorm({x, y}, closestRefVectorPosition)};
+	// Full rows are contiguous and can be processed at once
+	const bool processRowsAtOnce {rowSize == refVectors.getWidth()};
+	const std::size_t offset {refVectors.getIndex({xBegin, yBegin})};
 
-			InputVector delta {input - refVector};
-			delta *= (learningFactor * _neighbourhoodFunc(norm, iteration));
+	auto itInput {input.cbegin()};
+	for (std::size_t dimension {}; dimension < _inputDimCount; ++dimension)
+	{
+		T* values {refVectors.getDimensionValues(dimension) + offset};
+		const T inputValue {static_cast<T>(*itInput++)};
 
-			refVector += delta;
+		if (processRowsAtOnce)
+		{
+			Kernels::moveTowards(values, inputValue, factors.data(), factors.size());
+			continue;
 		}
+
+		for (Coordinate y {yBegin}; y < yEnd; ++y)
+			Kernels::moveTowards(values + static_cast<std::size_t>(y - yBegin) * refVectors.getWidth(), inputValue, factors.data() + (y - yBegin) * rowSize, rowSize);
 	}
 }
 
 void
 Network::train(const std::vector<InputVector>& inputData, std::size_t nbIterations, ProgressCallback progressCallback, RequestStopCallback requestStopCallback)
+{
+	// Check before any processing, so that the ref vectors are left untouched on error
+	for (const InputVector& data : inputData)
+		checkSameDimensions(data, _inputDimCount);
+
+	std::visit([&](auto& refVectors)
+	{
+		switch (_trainingAlgorithm)
+		{
+			case TrainingAlgorithm::Online:
+				trainOnline(refVectors, inputData, nbIterations, progressCallback, requestStopCallback);
+				break;
+
+			case TrainingAlgorithm::Batch:
+				trainBatch(refVectors, inputData, nbIterations, progressCallback, requestStopCallback);
+				break;
+		}
+	}, _refVectors);
+}
+
+template <typename T>
+void
+Network::trainOnline(RefVectorStorage<T>& refVectors, const std::vector<InputVector>& inputData, std::size_t nbIterations, ProgressCallback progressCallback, RequestStopCallback requestStopCallback)
 {
 	bool stopRequested {false};
 	std::vector<const InputVector*> inputDataShuffled;
+	typename RefVectorStorage<T>::Buffer factors;
 
 	inputDataShuffled.reserve(inputData.size());
 	for (const auto& input : inputData)
 		inputDataShuffled.push_back(&input);
 
+	factors.reserve(refVectors.getCount());
+
 	for (std::size_t i {}; i < nbIterations; ++i)
 	{
 		CurrentIteration curIter {i, nbIterations};
@@ -298,9 +536,10 @@ Network::train(const std::vector<InputVector>& inputData, std::size_t nbIteratio
 		if (progressCallback)
 			progressCallback(curIter);
 
-		Random::shuffleContainer(inputDataShuffled);
+		std::shuffle(std::begin(inputDataShuffled), std::end(inputDataShuffled), _randGenerator);
 
 		const LearningFactor learningFactor {_learningFactorFunc(curIter)};
+		const std::optional<Coordinate> neighbourhoodRadius {computeNeighbourhoodRadius(curIter)};
 
 		for (const InputVector* input : inputDataShuffled)
 		{
@@ -310,7 +549,10 @@ Network::train(const std::vector<InputVector>& inputData, std::size_t nbIteratio
 			if (stopRequested)
 				return;
 
-			updateRefVectors(getClosestRefVectorPosition(*input), *input, learningFactor, curIter);
+			if (!neighbourhoodRadius)
+				continue;
+
+			updateRefVectors(refVectors, refVectors.getPosition(getClosestRefVector(refVectors, *input).index), *input, learningFactor, curIter, *neighbourhoodRadius, factors);
 		}
 
 		if (stopRequested)
@@ -318,10 +560,111 @@ Network::train(const std::vector<InputVector>& inputData, std::size_t nbIteratio
 	}
 }
 
-const InputVector&
+// For each iteration:
+// - the closest ref vector of each sample is searched (in parallel)
+// - the samples are summed up by closest ref vector
+// - each ref vector is moved towards the mean of the samples, weighted by the neighbourhood of their closest ref vectors (in parallel)
+// The results do not depend on the number of threads
+template <typename T>
+void
+Network::trainBatch(RefVectorStorage<T>& refVectors, const std::vector<InputVector>& inputData, std::size_t nbIterations, ProgressCallback progressCallback, RequestStopCallback requestStopCallback)
+{
+	const std::size_t threadCount {getThreadCount()};
+	const std::size_t refVectorCount {refVectors.getCount()};
+	const std::size_t stride {refVectors.getStride()};
+
+	std::vector<std::size_t> closestRefVectorIndexes(inputData.size());
+	typename RefVectorStorage<T>::Buffer sampleCounts(stride);
+
+	for (std::size_t i {}; i < nbIterations; ++i)
+	{
+		const CurrentIteration curIter {i, nbIterations};
+
+		if (progressCallback)
+			progressCallback(curIter);
+
+		const LearningFactor learningFactor {_learningFactorFunc(curIter)};
+
+		if (!processBlocksInParallel(inputData.size(), threadCount, [&](std::size_t begin, std::size_t end)
+			{
+				for (std::size_t sampleIndex {begin}; sampleIndex < end; ++sampleIndex)
+					closestRefVectorIndexes[sampleIndex] = getClosestRefVector(refVectors, inputData[sampleIndex]).index;
+			}, requestStopCallback))
+		{
+			return;
+		}
+
+		// Sequential, in order to keep the results reproducible
+		RefVectorStorage<T> sampleSums {refVectors.getWidth(), refVectors.getHeight(), _inputDimCount};
+		std::fill(std::begin(sampleCounts), std::end(sampleCounts), 0);
+		for (std::size_t sampleIndex {}; sampleIndex < inputData.size(); ++sampleIndex)
+		{
+			const std::size_t refVectorIndex {closestRefVectorIndexes[sampleIndex]};
+
+			auto itInput {inputData[sampleIndex].cbegin()};
+			for (std::size_t dimension {}; dimension < _inputDimCount; ++dimension)
+				sampleSums.getDimensionValues(dimension)[refVectorIndex] += static_cast<T>(*itInput++);
+
+			sampleCounts[refVectorIndex]++;
+		}
+
+		RefVectorStorage<T> newRefVectors {refVectors};
+		if (!processBlocksInParallel(refVectorCount, threadCount, [&](std::size_t begin, std::size_t end)
+			{
+				// padding values must remain null
+				typename RefVectorStorage<T>::Buffer neighbourhoods(stride);
+
+				for (std::size_t refVectorIndex {begin}; refVectorIndex < end; ++refVectorIndex)
+				{
+					const Position position {refVectors.getPosition(refVectorIndex)};
+
+					for (std::size_t matchingIndex {}; matchingIndex < refVectorCount; ++matchingIndex)
+					{
+						InputVector::value_type neighbourhood {};
+						if (sampleCounts[matchingIndex] != 0)
+						{
+							neighbourhood = _neighbourhoodFunc(computePositionNorm(position, refVectors.getPosition(matchingIndex)), curIter);
+							if (neighbourhood < _neighbourhoodThreshold)
+								neighbourhood = 0;
+						}
+
+						neighbourhoods[matchingIndex] = static_cast<T>(neighbourhood);
+					}
+
+					const T denominator {Kernels::dotProduct(neighbourhoods.data(), sampleCounts.data(), stride)};
+					if (denominator <= 0)
+						continue;
+
+					for (std::size_t dimension {}; dimension < _inputDimCount; ++dimension)
+					{
+						const T mean {Kernels::dotProduct(neighbourhoods.data(), sampleSums.getDimensionValues(dimension), stride) / denominator};
+
+						T& value {newRefVectors.getDimensionValues(dimension)[refVectorIndex]};
+						value += static_cast<T>(learningFactor) * (mean - value);
+					}
+				}
+			}, requestStopCallback))
+		{
+			return;
+		}
+
+		refVectors = std::move(newRefVectors);
+	}
+}
+
+std::size_t
+Network::getThreadCount() const
+{
+	if (_threadCount)
+		return _threadCount;
+
+	return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+InputVector
 Network::getRefVector(const Position& position) const
 {
-	return _refVectors[position];
+	return std::visit([&](const auto& refVectors) { return refVectors.get(position); }, _refVectors);
 }
 
 
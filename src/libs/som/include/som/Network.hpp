@@ -19,13 +19,17 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <optional>
 #include <ostream>
 #include <functional>
+#include <variant>
 
+#include "utils/Random.hpp"
 #include "InputVector.hpp"
 #include "Matrix.hpp"
+#include "RefVectorStorage.hpp"
 
 namespace SOM
 {
@@ -41,10 +45,11 @@ class Network
 {
 	public:
 		// Init a network with random values
-		Network(Coordinate width, Coordinate height, std::size_t inputDimCount);
+		// Training results are reproducible if a seed is provided
+		Network(Coordinate width, Coordinate height, std::size_t inputDimCount, std::optional<std::uint_fast32_t> seed = std::nullopt);
 
-		Coordinate getWidth() const { return _refVectors.getWidth(); }
-		Coordinate getHeight() const { return _refVectors.getHeight(); }
+		Coordinate getWidth() const { return std::visit([](const auto& refVectors) { return refVectors.getWidth(); }, _refVectors); }
+		Coordinate getHeight() const { return std::visit([](const auto& refVectors) { return refVectors.getHeight(); }, _refVectors); }
 		std::size_t getInputDimCount() const { return _inputDimCount; }
 		const InputVector& getDataWeights() const { return _weights; }
 
@@ -64,7 +69,31 @@ class Network
 		using RequestStopCallback = std::function<bool()>;
 		void train(const std::vector<InputVector>& dataSamples, std::size_t nbIterations, ProgressCallback = ProgressCallback{}, RequestStopCallback = RequestStopCallback{});
 
-		const InputVector& getRefVector(const Position& position) const;
+		enum class TrainingAlgorithm
+		{
+			Online,	// ref vectors are updated after each sample
+			Batch,	// ref vectors are updated once per iteration, using all the samples (multithreaded)
+		};
+		void setTrainingAlgorithm(TrainingAlgorithm algorithm) { _trainingAlgorithm = algorithm; }
+		TrainingAlgorithm getTrainingAlgorithm() const { return _trainingAlgorithm; }
+
+		// Number of threads used by the batch algorithm, 0 means auto detect
+		void setThreadCount(std::size_t threadCount) { _threadCount = threadCount; }
+
+		// Precision used to store and compute the ref vectors (default is double)
+		enum class Precision
+		{
+			Double,
+			Float,	// faster, uses less memory
+		};
+		void setPrecision(Precision precision); // converts the current ref vectors
+		Precision getPrecision() const;
+
+		// During training, ref vectors for which the neighbourhood value is below this threshold are not updated
+		// Only the ref vectors close to the matching ref vector are then processed (default is 0, all the ref vectors are updated)
+		void setNeighbourhoodThreshold(InputVector::value_type threshold) { _neighbourhoodThreshold = threshold; }
+
+		InputVector getRefVector(const Position& position) const;
 		Position getClosestRefVectorPosition(const InputVector& data) const;
 		std::optional<Position> getClosestRefVectorPosition(const InputVector& data, InputVector::Distance maxDistance) const;
 
@@ -81,6 +110,8 @@ class Network
 		// i is the current iteration
 		// refVector(i+1) = refVector(i) + LearningFactor(i) * NeighbourhoodFunc(i) * (MatchingRefVector - refVector)
 
+		// Ref vectors are compared using a weighted euclidian square distance by default, computed using the SIMD kernels
+		// Setting a custom distance function makes the network fall back to slower per ref vector computations
 		using DistanceFunc = std::function<InputVector::Distance(const InputVector& /* a */, const InputVector& /* b */, const InputVector& /* weights */)>;
 		void setDistanceFunc(DistanceFunc distanceFunc);
 		DistanceFunc getDistanceFunc() { return _distanceFunc; }
@@ -93,13 +124,34 @@ class Network
 
 	private:
 
-		void updateRefVectors(const Position& closestRefVectorPosition, const InputVector& input, LearningFactor learningFactor, const CurrentIteration& iteration);
+		template <typename T>
+		void trainOnline(RefVectorStorage<T>& refVectors, const std::vector<InputVector>& dataSamples, std::size_t nbIterations, ProgressCallback progressCallback, RequestStopCallback requestStopCallback);
+		template <typename T>
+		void trainBatch(RefVectorStorage<T>& refVectors, const std::vector<InputVector>& dataSamples, std::size_t nbIterations, ProgressCallback progressCallback, RequestStopCallback requestStopCallback);
+		template <typename T>
+		void updateRefVectors(RefVectorStorage<T>& refVectors, const Position& closestRefVectorPosition, const InputVector& input, LearningFactor learningFactor, const CurrentIteration& iteration, Coordinate neighbourhoodRadius, typename RefVectorStorage<T>::Buffer& factors);
+		std::optional<Coordinate> computeNeighbourhoodRadius(const CurrentIteration& iteration) const;
 
+		struct ClosestRefVector
+		{
+			std::size_t index;
+			InputVector::Distance distance;
+		};
+		template <typename T>
+		ClosestRefVector getClosestRefVector(const RefVectorStorage<T>& refVectors, const InputVector& data) const;
+		ClosestRefVector getClosestRefVector(const InputVector& data) const;
+		std::size_t getThreadCount() const;
+
+		Random::RandGenerator _randGenerator;
+		TrainingAlgorithm _trainingAlgorithm {TrainingAlgorithm::Online};
+		std::size_t _threadCount {};
+		InputVector::value_type _neighbourhoodThreshold {};
 		std::size_t _inputDimCount {};
 		InputVector _weights;	// weight for each dimension
-		Matrix<InputVector> _refVectors;
+		std::variant<RefVectorStorage<double>, RefVectorStorage<float>> _refVectors;
 
 		DistanceFunc _distanceFunc;
+		bool _hasCustomDistanceFunc {};
 		LearningFactorFunc _learningFactorFunc;
 		NeighbourhoodFunc _neighbourhoodFunc;
 };
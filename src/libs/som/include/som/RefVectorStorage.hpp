@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "InputVector.hpp"
+#include "Matrix.hpp"
+
+namespace SOM
+{
+
+template <typename T, std::size_t Alignment>
+class AlignedAllocator
+{
+	public:
+		using value_type = T;
+
+		template <typename U>
+		struct rebind
+		{
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+		AlignedAllocator() = default;
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(std::size_t count)
+		{
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t {Alignment}));
+		}
+
+		void deallocate(T* ptr, std::size_t)
+		{
+			::operator delete(ptr, std::align_val_t {Alignment});
+		}
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+		template <typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// Stores the reference vectors of a network in a single contiguous buffer, dimension by dimension (structure of arrays)
+// The values of a given dimension are aligned and padded with zeros, so that they can be processed using SIMD instructions
+template <typename T>
+class RefVectorStorage
+{
+	public:
+		using value_type = T;
+
+		static constexpr std::size_t alignment {32};
+		static constexpr std::size_t valuesPerAlignment {alignment / sizeof(value_type)};
+
+		using Buffer = std::vector<value_type, AlignedAllocator<value_type, alignment>>;
+
+		RefVectorStorage() = default;
+		RefVectorStorage(Coordinate width, Coordinate height, std::size_t nbDimensions)
+		: _width {width}
+		, _height {height}
+		, _nbDimensions {nbDimensions}
+		, _stride {getPaddedCount(static_cast<std::size_t>(width) * height)}
+		, _values(_stride * nbDimensions)
+		{}
+
+		template <typename U>
+		explicit RefVectorStorage(const RefVectorStorage<U>& other)
+		: RefVectorStorage {other.getWidth(), other.getHeight(), other.getNbDimensions()}
+		{
+			for (std::size_t dimension {}; dimension < _nbDimensions; ++dimension)
+				std::copy(other.getDimensionValues(dimension), other.getDimensionValues(dimension) + other.getCount(), getDimensionValues(dimension));
+		}
+
+		// Number of values to be allocated in order to process count values at once
+		static constexpr std::size_t getPaddedCount(std::size_t count) { return (count + valuesPerAlignment - 1) / valuesPerAlignment * valuesPerAlignment; }
+
+		Coordinate getWidth() const { return _width; }
+		Coordinate getHeight() const { return _height; }
+		std::size_t getNbDimensions() const { return _nbDimensions; }
+		std::size_t getCount() const { return static_cast<std::size_t>(_width) * _height; }
+		std::size_t getStride() const { return _stride; } // padded count
+
+		std::size_t getIndex(const Position& position) const
+		{
+			assert(position.x < _width);
+			assert(position.y < _height);
+			return position.x + static_cast<std::size_t>(_width) * position.y;
+		}
+
+		Position getPosition(std::size_t index) const
+		{
+			assert(index < getCount());
+			return {static_cast<Coordinate>(index % _width), static_cast<Coordinate>(index / _width)};
+		}
+
+		// getStride() aligned values
+		value_type* getDimensionValues(std::size_t dimension) { return _values.data() + dimension * _stride; }
+		const value_type* getDimensionValues(std::size_t dimension) const { return _values.data() + dimension * _stride; }
+
+		InputVector get(const Position& position) const
+		{
+			const std::size_t index {getIndex(position)};
+
+			InputVector res {_nbDimensions};
+			for (std::size_t dimension {}; dimension < _nbDimensions; ++dimension)
+				res[dimension] = getDimensionValues(dimension)[index];
+
+			return res;
+		}
+
+		void set(const Position& position, const InputVector& values)
+		{
+			const std::size_t index {getIndex(position)};
+
+			for (std::size_t dimension {}; dimension < _nbDimensions; ++dimension)
+				getDimensionValues(dimension)[index] = static_cast<value_type>(values[dimension]);
+		}
+
+	private:
+		Coordinate	_width {};
+		Coordinate	_height {};
+		std::size_t	_nbDimensions {};
+		std::size_t	_stride {};
+		Buffer		_values;
+};
+
+} // namespace SOM
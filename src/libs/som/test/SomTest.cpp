@@ -17,6 +17,7 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <random>
 #include <unordered_set>
 #include <gtest/gtest.h>
 #include "som/DataNormalizer.hpp"
@@ -126,6 +127,320 @@ TEST(som, Network)
 	}
 }
 
+static
+std::vector<InputVector>
+generateTrainData(std::size_t sampleCount, std::size_t nbDimensions)
+{
+	std::mt19937 generator {42};
+	std::uniform_real_distribution<InputVector::value_type> dist {0, 1};
+
+	std::vector<InputVector> trainData;
+	for (std::size_t i {}; i < sampleCount; ++i)
+	{
+		InputVector data {nbDimensions};
+		for (InputVector::value_type& value : data)
+			value = dist(generator);
+
+		trainData.push_back(data);
+	}
+
+	return trainData;
+}
+
+static
+void
+expectSameRefVectors(const Network& network1, const Network& network2)
+{
+	ASSERT_EQ(network1.getWidth(), network2.getWidth());
+	ASSERT_EQ(network1.getHeight(), network2.getHeight());
+
+	for (Coordinate y {}; y < network1.getHeight(); ++y)
+	{
+		for (Coordinate x {}; x < network1.getWidth(); ++x)
+		{
+			const InputVector refVector1 {network1.getRefVector({x, y})};
+			const InputVector refVector2 {network2.getRefVector({x, y})};
+
+			for (std::size_t i {}; i < network1.getInputDimCount(); ++i)
+				EXPECT_EQ(refVector1[i], refVector2[i]);
+		}
+	}
+}
+
+TEST(som, NetworkBatch)
+{
+	Network network {2, 2, 1, 1234};
+	network.setTrainingAlgorithm(Network::TrainingAlgorithm::Batch);
+
+	std::vector<InputVector> trainData
+	{
+		{ 1, 50 },
+		{ 1, 100 },
+		{ 1, 150 },
+		{ 1, 200 },
+	};
+
+	DataNormalizer normalizer {1};
+	normalizer.computeNormalizationFactors(trainData);
+	for (auto& data: trainData)
+		normalizer.normalizeData(data);
+
+	network.train(trainData, 20);
+
+	std::unordered_set<Position> positions;
+	for (const InputVector& data : trainData)
+		positions.insert(network.getClosestRefVectorPosition(data));
+
+	EXPECT_EQ(positions.size(), 4);
+}
+
+TEST(som, NetworkReproducible)
+{
+	const std::vector<InputVector> trainData {generateTrainData(200, 3)};
+
+	for (const Network::TrainingAlgorithm algorithm : {Network::TrainingAlgorithm::Online, Network::TrainingAlgorithm::Batch})
+	{
+		Network network1 {5, 5, 3, 1234};
+		network1.setTrainingAlgorithm(algorithm);
+		network1.setThreadCount(1);
+		network1.train(trainData, 5);
+
+		Network network2 {5, 5, 3, 1234};
+		network2.setTrainingAlgorithm(algorithm);
+		network2.setThreadCount(4);
+		network2.train(trainData, 5);
+
+		expectSameRefVectors(network1, network2);
+	}
+}
+
+TEST(som, NetworkRequestStop)
+{
+	const std::vector<InputVector> trainData {generateTrainData(200, 3)};
+
+	for (const Network::TrainingAlgorithm algorithm : {Network::TrainingAlgorithm::Online, Network::TrainingAlgorithm::Batch})
+	{
+		Network network {5, 5, 3, 1234};
+		network.setTrainingAlgorithm(algorithm);
+
+		const Network reference {network};
+
+		std::size_t iterationCount {};
+		network.train(trainData, 5, [&](const Network::CurrentIteration&) { iterationCount++; }, [] { return true; });
+
+		EXPECT_EQ(iterationCount, 1);
+		expectSameRefVectors(network, reference);
+	}
+}
+
+TEST(som, NetworkBadData)
+{
+	std::vector<InputVector> trainData {generateTrainData(200, 3)};
+	trainData.back() = InputVector {2};
+
+	for (const Network::TrainingAlgorithm algorithm : {Network::TrainingAlgorithm::Online, Network::TrainingAlgorithm::Batch})
+	{
+		Network network {5, 5, 3, 1234};
+		network.setTrainingAlgorithm(algorithm);
+		network.setThreadCount(4);
+
+		const Network reference {network};
+
+		EXPECT_THROW(network.train(trainData, 5), Exception);
+		expectSameRefVectors(network, reference);
+	}
+}
+
+TEST(som, NetworkBatchWorkerException)
+{
+	const std::vector<InputVector> trainData {generateTrainData(200, 3)};
+
+	Network network {5, 5, 3, 1234};
+	network.setTrainingAlgorithm(Network::TrainingAlgorithm::Batch);
+	network.setThreadCount(4);
+	network.setNeighbourhoodFunc([](Norm, const Network::CurrentIteration&) -> InputVector::value_type { throw Exception {"Neighbourhood failure"}; });
+
+	// thrown from the worker threads, must be reported to the caller
+	EXPECT_THROW(network.train(trainData, 5), Exception);
+}
+
+template <typename T>
+static
+void
+testRefVectorStorage()
+{
+	RefVectorStorage<T> storage {3, 2, 2};
+	EXPECT_EQ(storage.getCount(), 6);
+	EXPECT_EQ(storage.getStride() % RefVectorStorage<T>::valuesPerAlignment, 0);
+	EXPECT_GE(storage.getStride(), storage.getCount());
+
+	for (std::size_t dimension {}; dimension < storage.getNbDimensions(); ++dimension)
+		EXPECT_EQ(reinterpret_cast<std::uintptr_t>(storage.getDimensionValues(dimension)) % RefVectorStorage<T>::alignment, 0);
+
+	for (std::size_t index {}; index < storage.getCount(); ++index)
+	{
+		const Position position {storage.getPosition(index)};
+		EXPECT_EQ(storage.getIndex(position), index);
+
+		InputVector values {2};
+		values[0] = index;
+		values[1] = -values[0];
+		storage.set(position, values);
+	}
+
+	const InputVector values {storage.get({1, 1})};
+	EXPECT_EQ(values[0], 4);
+	EXPECT_EQ(values[1], -4);
+}
+
+TEST(som, RefVectorStorage)
+{
+	testRefVectorStorage<double>();
+	testRefVectorStorage<float>();
+}
+
+TEST(som, NetworkClosestRefVector)
+{
+	const std::vector<InputVector> trainData {generateTrainData(100, 7)};
+
+	Network network {7, 5, 7, 1234};
+	InputVector weights {7};
+	for (std::size_t i {}; i < weights.getNbDimensions(); ++i)
+		weights[i] = 1 + i;
+	network.setDataWeights(weights);
+
+	for (const InputVector& data : trainData)
+	{
+		std::optional<Position> expectedPosition;
+		InputVector::Distance minDistance {};
+		for (Coordinate y {}; y < network.getHeight(); ++y)
+		{
+			for (Coordinate x {}; x < network.getWidth(); ++x)
+			{
+				const InputVector::Distance distance {network.getRefVector({x, y}).computeEuclidianSquareDistance(data, weights)};
+				if (!expectedPosition || distance < minDistance)
+				{
+					expectedPosition = Position {x, y};
+					minDistance = distance;
+				}
+			}
+		}
+
+		EXPECT_EQ(network.getClosestRefVectorPosition(data), *expectedPosition);
+		EXPECT_FALSE(network.getClosestRefVectorPosition(data, minDistance * 0.99));
+		EXPECT_EQ(network.getClosestRefVectorPosition(data, minDistance * 1.01), *expectedPosition);
+	}
+}
+
+TEST(som, NetworkCustomDistance)
+{
+	const std::vector<InputVector> trainData {generateTrainData(100, 3)};
+
+	// manhattan distance
+	std::size_t nbCalls {};
+	auto distanceFunc {[&](const InputVector& a, const InputVector& b, const InputVector& weights)
+	{
+		nbCalls++;
+
+		InputVector::Distance res {};
+		for (std::size_t i {}; i < a.getNbDimensions(); ++i)
+			res += std::abs(a[i] - b[i]) * weights[i];
+		return res;
+	}};
+
+	Network network {4, 4, 3, 1234};
+	network.setDistanceFunc(distanceFunc);
+	network.train(trainData, 5);
+	EXPECT_GT(nbCalls, 0);
+
+	const InputVector weights {3, 1};
+	for (const InputVector& data : trainData)
+	{
+		std::optional<Position> expectedPosition;
+		InputVector::Distance minDistance {};
+		for (Coordinate y {}; y < network.getHeight(); ++y)
+		{
+			for (Coordinate x {}; x < network.getWidth(); ++x)
+			{
+				const InputVector::Distance distance {distanceFunc(network.getRefVector({x, y}), data, weights)};
+				if (!expectedPosition || distance < minDistance)
+				{
+					expectedPosition = Position {x, y};
+					minDistance = distance;
+				}
+			}
+		}
+
+		EXPECT_EQ(network.getClosestRefVectorPosition(data), *expectedPosition);
+	}
+
+	EXPECT_LT(std::abs(network.getRefVectorsDistance({0, 0}, {1, 0}) - distanceFunc(network.getRefVector({0, 0}), network.getRefVector({1, 0}), weights)), EPSILON);
+}
+
+TEST(som, NetworkFloat)
+{
+	for (const Network::TrainingAlgorithm algorithm : {Network::TrainingAlgorithm::Online, Network::TrainingAlgorithm::Batch})
+	{
+		Network network {2, 2, 1, 1234};
+		network.setTrainingAlgorithm(algorithm);
+		network.setPrecision(Network::Precision::Float);
+		EXPECT_EQ(network.getPrecision(), Network::Precision::Float);
+
+		std::vector<InputVector> trainData
+		{
+			{ 1, 50 },
+			{ 1, 100 },
+			{ 1, 150 },
+			{ 1, 200 },
+		};
+
+		DataNormalizer normalizer {1};
+		normalizer.computeNormalizationFactors(trainData);
+		for (auto& data: trainData)
+			normalizer.normalizeData(data);
+
+		network.train(trainData, 20);
+
+		std::unordered_set<Position> positions;
+		for (const InputVector& data : trainData)
+			positions.insert(network.getClosestRefVectorPosition(data));
+
+		EXPECT_EQ(positions.size(), 4);
+	}
+}
+
+TEST(som, NetworkNeighbourhoodThreshold)
+{
+	const std::vector<InputVector> trainData {generateTrainData(1, 3)};
+
+	Network network {10, 10, 3, 1234};
+	network.setNeighbourhoodThreshold(0.01);
+
+	const Network reference {network};
+	const Position closestPosition {network.getClosestRefVectorPosition(trainData.front())};
+
+	// with a single iteration, the neighbourhood value is below the threshold for ref vectors that are not direct neighbours
+	network.train(trainData, 1);
+
+	for (Coordinate y {}; y < network.getHeight(); ++y)
+	{
+		for (Coordinate x {}; x < network.getWidth(); ++x)
+		{
+			const InputVector refVector {network.getRefVector({x, y})};
+			const InputVector referenceRefVector {reference.getRefVector({x, y})};
+			const bool isNeighbour {std::abs(static_cast<int>(x) - static_cast<int>(closestPosition.x)) + std::abs(static_cast<int>(y) - static_cast<int>(closestPosition.y)) <= 1};
+
+			for (std::size_t i {}; i < network.getInputDimCount(); ++i)
+			{
+				if (isNeighbour)
+					EXPECT_NE(refVector[i], referenceRefVector[i]);
+				else
+					EXPECT_EQ(refVector[i], referenceRefVector[i]);
+			}
+		}
+	}
+}
+
 int main(int argc, char **argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
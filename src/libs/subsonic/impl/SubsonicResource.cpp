@@ -1469,7 +1469,7 @@ handleSearchRequestCommon(RequestContext& context, bool id3)
 	{
 		Artist::FindParameters params;
 		params.setKeywords(keywords);
-		params.setSortMethod(ArtistSortMethod::BySortName);
+		params.setSortMethod(ArtistSortMethod::Relevance);
 		params.setRange({artistOffset, artistCount});
 
 		RangeResults<ArtistId> artistIds {Artist::find(context.dbSession, params)};
@@ -1483,7 +1483,7 @@ handleSearchRequestCommon(RequestContext& context, bool id3)
 	{
 		Release::FindParameters params;
 		params.setKeywords(keywords);
-		params.setSortMethod(ReleaseSortMethod::Name);
+		params.setSortMethod(ReleaseSortMethod::Relevance);
 		params.setRange({albumOffset, albumCount});
 
 		RangeResults<ReleaseId> releaseIds {Release::find(context.dbSession, params)};
@@ -1497,6 +1497,7 @@ handleSearchRequestCommon(RequestContext& context, bool id3)
 	{
 		Track::FindParameters params;
 		params.setKeywords(keywords);
+		params.setSortMethod(TrackSortMethod::Relevance);
 		params.setRange({songOffset, songCount});
 
 		RangeResults<TrackId> trackIds {Track::find(context.dbSession, params)};
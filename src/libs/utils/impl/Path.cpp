@@ -69,13 +69,19 @@ ensureDirectory(const std::filesystem::path& dir)
 
 Wt::WDateTime
 getLastWriteTime(const std::filesystem::path& file)
+{
+	return getFileInfo(file).lastWriteTime;
+}
+
+FileInfo
+getFileInfo(const std::filesystem::path& file)
 {
 	struct stat sb {};
 
 	if (stat(file.string().c_str(), &sb) == -1)
 		throw LmsException("Failed to get stats on file '" + file.string() + "'" );
 
-	return Wt::WDateTime::fromTime_t(sb.st_mtime);
+	return FileInfo {Wt::WDateTime::fromTime_t(sb.st_mtime), static_cast<std::uintmax_t>(sb.st_size)};
 }
 
 bool
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/RecursiveWriterMutex.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace
+{
+	struct OwnerCounts
+	{
+		const RecursiveWriterMutex* mutex {};
+		std::size_t uniqueCount {};
+		std::size_t sharedCount {};
+	};
+
+	// Only contains the mutexes owned by the current thread
+	thread_local std::vector<OwnerCounts> threadOwnerCounts;
+
+	std::vector<OwnerCounts>::iterator
+	findOwnerCounts(const RecursiveWriterMutex* mutex)
+	{
+		return std::find_if(std::begin(threadOwnerCounts), std::end(threadOwnerCounts), [=](const OwnerCounts& counts) { return counts.mutex == mutex; });
+	}
+
+	OwnerCounts&
+	getOrCreateOwnerCounts(const RecursiveWriterMutex* mutex)
+	{
+		auto it {findOwnerCounts(mutex)};
+		if (it == std::end(threadOwnerCounts))
+			return threadOwnerCounts.emplace_back(OwnerCounts {mutex});
+
+		return *it;
+	}
+
+	void
+	releaseOwnerCountsIfUnused(const RecursiveWriterMutex* mutex)
+	{
+		auto it {findOwnerCounts(mutex)};
+		assert(it != std::end(threadOwnerCounts));
+		if (it->uniqueCount == 0 && it->sharedCount == 0)
+			threadOwnerCounts.erase(it);
+	}
+}
+
+void
+RecursiveWriterMutex::lock()
+{
+	OwnerCounts& counts {getOrCreateOwnerCounts(this)};
+
+	if (counts.uniqueCount == 0)
+	{
+		// the snapshot of a shared owner would prevent it from writing
+		assert(counts.sharedCount == 0);
+		_mutex.lock();
+	}
+
+	counts.uniqueCount++;
+}
+
+void
+RecursiveWriterMutex::unlock()
+{
+	auto it {findOwnerCounts(this)};
+	assert(it != std::end(threadOwnerCounts) && it->uniqueCount > 0);
+
+	if (--it->uniqueCount == 0)
+	{
+		_mutex.unlock();
+		releaseOwnerCountsIfUnused(this);
+	}
+}
+
+void
+RecursiveWriterMutex::lock_shared()
+{
+	// no lock here, the shared owner only needs to be tracked
+	getOrCreateOwnerCounts(this).sharedCount++;
+}
+
+void
+RecursiveWriterMutex::unlock_shared()
+{
+	auto it {findOwnerCounts(this)};
+	assert(it != std::end(threadOwnerCounts) && it->sharedCount > 0);
+
+	if (--it->sharedCount == 0)
+		releaseOwnerCountsIfUnused(this);
+}
+
+bool
+RecursiveWriterMutex::isUniqueLocked() const
+{
+	auto it {findOwnerCounts(this)};
+	return it != std::end(threadOwnerCounts) && it->uniqueCount > 0;
+}
+
+bool
+RecursiveWriterMutex::isSharedLocked() const
+{
+	// unique owners are also shared owners
+	return findOwnerCounts(this) != std::end(threadOwnerCounts);
+}
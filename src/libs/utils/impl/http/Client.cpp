@@ -23,9 +23,21 @@
 namespace Http
 {
 	std::unique_ptr<IClient>
-	createClient(boost::asio::io_context& ioContext, std::string_view baseUrl)
+	createClient(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t maxResponseSize)
 	{
-		return std::make_unique<Client>(ioContext, baseUrl);
+		return std::make_unique<Client>(ioContext, baseUrl, maxResponseSize, std::make_shared<RateLimit>());
+	}
+
+	std::vector<std::unique_ptr<IClient>>
+	createClients(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t clientCount, std::size_t maxResponseSize)
+	{
+		const auto rateLimit {std::make_shared<RateLimit>()};
+
+		std::vector<std::unique_ptr<IClient>> clients;
+		for (std::size_t i {}; i < clientCount; ++i)
+			clients.emplace_back(std::make_unique<Client>(ioContext, baseUrl, maxResponseSize, rateLimit));
+
+		return clients;
 	}
 
 	void
@@ -31,8 +31,8 @@ namespace Http
 	class Client final : public IClient
 	{
 		public:
-			Client(boost::asio::io_context& ioContext, std::string_view baseUrl)
-			: _sendQueue {ioContext, baseUrl}
+			Client(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t maxResponseSize, std::shared_ptr<RateLimit> rateLimit)
+			: _sendQueue {ioContext, baseUrl, maxResponseSize, std::move(rateLimit)}
 			{}
 
 		private:
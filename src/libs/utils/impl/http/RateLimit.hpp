@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+namespace Http
+{
+	// Shared by the send queues of clients subject to the same rate limits (same server, same IP):
+	// once one of them is rate limited, the others must wait as well
+	class RateLimit
+	{
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			void delayUntil(Clock::time_point resetTime)
+			{
+				std::scoped_lock lock {_mutex};
+				_resetTime = std::max(_resetTime, resetTime);
+			}
+
+			Clock::time_point getResetTime() const
+			{
+				std::scoped_lock lock {_mutex};
+				return _resetTime;
+			}
+
+		private:
+			mutable std::mutex	_mutex;
+			Clock::time_point	_resetTime;
+	};
+} // namespace Http
@@ -19,6 +19,8 @@
 
 #include "SendQueue.hpp"
 
+#include <algorithm>
+
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/bind_executor.hpp>
 
@@ -60,10 +62,12 @@ namespace
 
 namespace Http
 {
-	SendQueue::SendQueue(boost::asio::io_context& ioContext, std::string_view baseUrl)
+	SendQueue::SendQueue(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t maxResponseSize, std::shared_ptr<RateLimit> rateLimit)
 	: _ioContext {ioContext}
 	, _baseUrl {baseUrl}
+	, _rateLimit {std::move(rateLimit)}
 	{
+		_client.setMaximumResponseSize(maxResponseSize);
 		_client.done().connect([this](Wt::AsioWrapper::error_code ec, const Wt::Http::Message& msg)
 		{
 			_strand.dispatch([=, msg = std::move(msg)]
@@ -96,6 +100,15 @@ namespace Http
 		assert(_state == State::Idle);
 		assert(!_currentRequest);
 
+		// Another client subject to the same rate limits may have been rate limited
+		const RateLimit::Clock::time_point resetTime {_rateLimit->getResetTime()};
+		if (resetTime > RateLimit::Clock::now() && hasQueuedRequests())
+		{
+			LOG(DEBUG) << "Rate limited, waiting";
+			waitUntil(resetTime);
+			return;
+		}
+
 		for (auto& [prio, requests] : _sendQueue)
 		{
 			LOG(DEBUG) << "Processing prio " << static_cast<int>(prio) << ", request count = " << requests.size();
@@ -105,7 +118,11 @@ namespace Http
 				requests.pop_front();
 
 				if (!sendRequest(*request))
+				{
+					if (request->getParameters().onFailureFunc)
+						request->getParameters().onFailureFunc();
 					continue;
+				}
 
 				_state = State::Sending;
 				_currentRequest = std::move(request);
@@ -194,6 +211,9 @@ namespace Http
 		{
 			const auto waitDuration {headerReadAs<std::chrono::seconds>(msg, "X-RateLimit-Reset-In")};
 			throttle(waitDuration.value_or(_defaultRetryWaitDuration));
+
+			// Rate limits apply to all the clients sharing them
+			_rateLimit->delayUntil(_throttleTimer.expiry());
 		}
 
 		if (!mustThrottle)
@@ -215,15 +235,27 @@ namespace Http
 			sendNextQueuedRequest();
 	}
 
+	bool
+	SendQueue::hasQueuedRequests() const
+	{
+		return std::any_of(std::cbegin(_sendQueue), std::cend(_sendQueue), [](const auto& prioRequests) { return !prioRequests.second.empty(); });
+	}
+
 	void
 	SendQueue::throttle(std::chrono::seconds requestedDuration)
 	{
-		assert(_state == State::Idle);
-
 		const std::chrono::seconds duration {clamp(requestedDuration, _minRetryWaitDuration, _maxRetryWaitDuration)};
 		LOG(DEBUG) << "Throttling for " << duration.count() << " seconds";
 
-		_throttleTimer.expires_after(duration);
+		waitUntil(RateLimit::Clock::now() + duration);
+	}
+
+	void
+	SendQueue::waitUntil(RateLimit::Clock::time_point time)
+	{
+		assert(_state == State::Idle);
+
+		_throttleTimer.expires_at(time);
 		_throttleTimer.async_wait([this](const boost::system::error_code& ec)
 		{
 			if (ec == boost::asio::error::operation_aborted)
@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <deque>
+#include <memory>
 #include <vector>
 #include <string_view>
 
@@ -29,13 +31,14 @@
 
 #include <Wt/Http/Client.h>
 #include "ClientRequest.hpp"
+#include "RateLimit.hpp"
 
 namespace Http
 {
 	class SendQueue
 	{
 		public:
-			SendQueue(boost::asio::io_context& ioContext, std::string_view baseUrl);
+			SendQueue(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t maxResponseSize, std::shared_ptr<RateLimit> rateLimit);
 			~SendQueue();
 
 			SendQueue(const SendQueue&) = delete;
@@ -52,6 +55,8 @@ namespace Http
 			void onClientDoneError(std::unique_ptr<ClientRequest> request, Wt::AsioWrapper::error_code ec);
 			void onClientDoneSuccess(std::unique_ptr<ClientRequest> request, const Wt::Http::Message& msg);
 			void throttle(std::chrono::seconds duration);
+			void waitUntil(RateLimit::Clock::time_point time);
+			bool hasQueuedRequests() const;
 
 			const std::size_t			_maxRetryCount {2};
 			const std::chrono::seconds	_defaultRetryWaitDuration {30};
@@ -62,6 +67,7 @@ namespace Http
 			boost::asio::io_context::strand	_strand {_ioContext};
 			boost::asio::steady_timer		_throttleTimer {_ioContext};
 			std::string						_baseUrl;
+			std::shared_ptr<RateLimit>		_rateLimit;
 
 			enum class State
 			{
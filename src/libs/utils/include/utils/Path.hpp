@@ -35,6 +35,15 @@ bool ensureDirectory(const std::filesystem::path& dir);
 // Get the last write time since Epoch
 Wt::WDateTime getLastWriteTime(const std::filesystem::path& dir);
 
+struct FileInfo
+{
+	Wt::WDateTime	lastWriteTime;
+	std::uintmax_t	size {};
+};
+
+// Get the last write time and the size of a file, using a single stat call
+FileInfo getFileInfo(const std::filesystem::path& file);
+
 // returns false if aborted by user
 bool exploreFilesRecursive(const std::filesystem::path& directory, std::function<bool(std::error_code, const std::filesystem::path&)> cb, const std::filesystem::path& excludeDirFileName = {});
 
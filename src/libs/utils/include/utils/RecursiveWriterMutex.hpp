@@ -20,12 +20,12 @@
 #pragma once
 
 #include <mutex>
-#include <shared_mutex>
-#include <thread>
-#include <unordered_map>
 
 // API compatible with shared_mutex
-class RecursiveSharedMutex
+// Only the unique owners are serialized (recursively): shared owners never wait and must rely on
+// some kind of snapshot isolation to be protected against concurrent writes (like SQLite in WAL mode)
+// Ownership is tracked using thread local counters
+class RecursiveWriterMutex
 {
 	public:
 		void lock();
@@ -34,16 +34,9 @@ class RecursiveSharedMutex
 		void lock_shared();
 		void unlock_shared();
 
-#ifndef NDEBUG
-		bool isSharedLocked();
-		bool isUniqueLocked();
-#endif // NDEBUG
-	private:
-		std::shared_mutex _mutex;
-		std::thread::id _uniqueOwner;
-		std::size_t _uniqueCount{};
+		bool isSharedLocked() const;
+		bool isUniqueLocked() const;
 
-		std::mutex _sharedCountMutex;
-		std::unordered_map<std::thread::id, std::size_t> _sharedCounts;
+	private:
+		std::mutex _mutex;
 };
-
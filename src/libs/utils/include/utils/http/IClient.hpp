@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include <memory>
 #include <string_view>
+#include <vector>
 #include <boost/asio/io_context.hpp>
 
 #include "utils/http/ClientRequestParameters.hpp"
@@ -35,6 +37,10 @@ namespace Http
 			virtual void sendPOSTRequest(ClientPOSTRequestParameters&& request) = 0;
 	};
 
-	std::unique_ptr<IClient> createClient(boost::asio::io_context& ioContext, std::string_view baseUrl);
+	// Responses bigger than maxResponseSize are considered as failures
+	std::unique_ptr<IClient> createClient(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t maxResponseSize = 64 * 1024);
+
+	// Clients sharing the same rate limits: as soon as one of them is rate limited, all of them wait
+	std::vector<std::unique_ptr<IClient>> createClients(boost::asio::io_context& ioContext, std::string_view baseUrl, std::size_t clientCount, std::size_t maxResponseSize = 64 * 1024);
 } // namespace Http
 
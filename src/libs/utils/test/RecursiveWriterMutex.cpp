@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utils/RecursiveWriterMutex.hpp"
+
+TEST(RecursiveWriterMutex, SingleThreaded)
+{
+	{
+		RecursiveWriterMutex mutex;
+		EXPECT_FALSE(mutex.isSharedLocked());
+		EXPECT_FALSE(mutex.isUniqueLocked());
+
+		{
+			std::unique_lock lock {mutex};
+			EXPECT_TRUE(mutex.isSharedLocked());
+			EXPECT_TRUE(mutex.isUniqueLocked());
+		}
+		EXPECT_FALSE(mutex.isSharedLocked());
+		EXPECT_FALSE(mutex.isUniqueLocked());
+
+		{
+			std::shared_lock lock {mutex};
+			EXPECT_TRUE(mutex.isSharedLocked());
+			EXPECT_FALSE(mutex.isUniqueLocked());
+		}
+		EXPECT_FALSE(mutex.isSharedLocked());
+
+		{
+			std::unique_lock lock1 {mutex};
+			std::unique_lock lock2 {mutex};
+		}
+
+		{
+			std::shared_lock lock1 {mutex};
+			std::shared_lock lock2 {mutex};
+		}
+
+		{
+			std::unique_lock lock1 {mutex};
+			{
+				std::shared_lock lock2 {mutex};
+			}
+			EXPECT_TRUE(mutex.isUniqueLocked());
+		}
+		EXPECT_FALSE(mutex.isSharedLocked());
+		EXPECT_FALSE(mutex.isUniqueLocked());
+	}
+}
+
+TEST(RecursiveWriterMutex, MultipleMutexes)
+{
+	RecursiveWriterMutex mutex1;
+	RecursiveWriterMutex mutex2;
+
+	std::unique_lock lock1 {mutex1};
+	std::shared_lock lock2 {mutex2};
+
+	EXPECT_TRUE(mutex1.isUniqueLocked());
+	EXPECT_FALSE(mutex2.isUniqueLocked());
+	EXPECT_TRUE(mutex2.isSharedLocked());
+}
+
+TEST(RecursiveWriterMutex, MultiThreaded)
+{
+	{
+		constexpr std::size_t nbThreads {10};
+		std::vector<std::thread> threads;
+
+		RecursiveWriterMutex mutex;
+		std::atomic<std::size_t> nbUnique {};
+		for (std::size_t i {}; i < nbThreads; ++i)
+		{
+			threads.emplace_back([&]
+			{
+				{
+					std::unique_lock lock {mutex};
+					std::unique_lock lock2 {mutex};
+
+					EXPECT_EQ(nbUnique, 0);
+					nbUnique++;
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+					EXPECT_EQ(nbUnique, 1);
+					nbUnique--;
+				}
+
+				for (std::size_t j {}; j < 10; ++j)
+				{
+					std::shared_lock lock {mutex};
+					std::shared_lock lock2 {mutex};
+
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					EXPECT_TRUE(mutex.isSharedLocked());
+					EXPECT_FALSE(mutex.isUniqueLocked());
+				}
+			});
+		}
+
+		for (std::thread& t : threads)
+			t.join();
+	}
+}
+
+TEST(RecursiveWriterMutex, MultiThreadedSharedWhileUnique)
+{
+	constexpr std::size_t nbThreads {10};
+
+	RecursiveWriterMutex mutex;
+	std::mutex stateMutex;
+	std::condition_variable stateCondVar;
+	bool uniqueLocked {};
+	std::size_t nbSharedWhileUnique {};
+
+	// the writer holds its lock until all the readers got their shared lock
+	std::thread writer {[&]
+	{
+		std::unique_lock lock {mutex};
+
+		std::unique_lock stateLock {stateMutex};
+		uniqueLocked = true;
+		stateCondVar.notify_all();
+
+		EXPECT_TRUE(stateCondVar.wait_for(stateLock, std::chrono::seconds {5}, [&] { return nbSharedWhileUnique == nbThreads; }));
+	}};
+
+	std::vector<std::thread> readers;
+	for (std::size_t i {}; i < nbThreads; ++i)
+	{
+		readers.emplace_back([&]
+		{
+			{
+				std::unique_lock stateLock {stateMutex};
+				stateCondVar.wait(stateLock, [&] { return uniqueLocked; });
+			}
+
+			std::shared_lock lock {mutex};
+			std::shared_lock lock2 {mutex};
+			EXPECT_TRUE(mutex.isSharedLocked());
+			EXPECT_FALSE(mutex.isUniqueLocked());
+
+			std::scoped_lock stateLock {stateMutex};
+			nbSharedWhileUnique++;
+			stateCondVar.notify_all();
+		});
+	}
+
+	for (std::thread& reader : readers)
+		reader.join();
+	writer.join();
+
+	EXPECT_EQ(nbSharedWhileUnique, nbThreads);
+}
+
+TEST(RecursiveWriterMutex, SharedLockWhileUniqueLocked)
+{
+	RecursiveWriterMutex mutex;
+	std::promise<void> uniqueLocked;
+	std::promise<void> releaseUniqueLock;
+
+	std::thread writer {[&]
+	{
+		std::unique_lock lock {mutex};
+		uniqueLocked.set_value();
+		releaseUniqueLock.get_future().wait();
+	}};
+	uniqueLocked.get_future().wait();
+
+	// the reader must not wait for the writer to release its lock
+	std::future<void> reader {std::async(std::launch::async, [&]
+	{
+		std::shared_lock lock {mutex};
+		EXPECT_TRUE(mutex.isSharedLocked());
+		EXPECT_FALSE(mutex.isUniqueLocked());
+	})};
+	EXPECT_EQ(reader.wait_for(std::chrono::seconds {5}), std::future_status::ready);
+
+	releaseUniqueLock.set_value();
+	writer.join();
+	reader.wait();
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2022 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/RecursiveWriterMutex.hpp"
+
+// Measures the shared locks that reader threads manage to take while a writer regularly holds the unique lock
+// Not a unit test: figures depend on the machine and are only meant to be compared between mutexes
+
+namespace
+{
+	// Former database mutex: shared owners are counted in a map protected by an internal mutex,
+	// and the unique owner excludes all the shared ones
+	class RecursiveSharedMutex
+	{
+		public:
+			void lock()
+			{
+				const auto thisThreadId {std::this_thread::get_id()};
+				if (_uniqueOwner == thisThreadId)
+				{
+					_uniqueCount++;
+					return;
+				}
+
+				_mutex.lock();
+				_uniqueOwner = thisThreadId;
+				_uniqueCount = 1;
+			}
+
+			void unlock()
+			{
+				assert(_uniqueCount > 0);
+				if (--_uniqueCount == 0)
+				{
+					_uniqueOwner = {};
+					_mutex.unlock();
+				}
+			}
+
+			void lock_shared()
+			{
+				const auto thisThreadId {std::this_thread::get_id()};
+				bool needLock {};
+
+				{
+					std::scoped_lock lock {_sharedCountMutex};
+
+					auto& sharedCount {_sharedCounts[thisThreadId]};
+					if (sharedCount == 0)
+						needLock = true;
+					else
+						++sharedCount;
+				}
+
+				if (needLock)
+				{
+					_mutex.lock_shared();
+
+					std::scoped_lock lock {_sharedCountMutex};
+					_sharedCounts[thisThreadId]++;
+				}
+			}
+
+			void unlock_shared()
+			{
+				bool needUnlock {};
+
+				{
+					std::scoped_lock lock {_sharedCountMutex};
+					needUnlock = (--_sharedCounts[std::this_thread::get_id()] == 0);
+				}
+
+				if (needUnlock)
+					_mutex.unlock_shared();
+			}
+
+		private:
+			std::shared_mutex _mutex;
+			std::thread::id _uniqueOwner;
+			std::size_t _uniqueCount {};
+
+			std::mutex _sharedCountMutex;
+			std::unordered_map<std::thread::id, std::size_t> _sharedCounts;
+	};
+
+	template <typename Mutex>
+	std::size_t
+	benchmarkSharedLocks(std::size_t nbThreads, std::chrono::milliseconds duration)
+	{
+		Mutex mutex;
+		std::atomic<bool> stop {};
+		std::atomic<std::size_t> nbSharedLocks {};
+
+		std::vector<std::thread> threads;
+		for (std::size_t i {}; i < nbThreads; ++i)
+		{
+			threads.emplace_back([&]
+			{
+				std::size_t count {};
+				while (!stop)
+				{
+					// transactions are often nested
+					std::shared_lock lock {mutex};
+					std::shared_lock lock2 {mutex};
+					++count;
+				}
+				nbSharedLocks += count;
+			});
+		}
+
+		// a writer regularly holds the lock, like the scanner does
+		const auto start {std::chrono::steady_clock::now()};
+		while (std::chrono::steady_clock::now() - start < duration)
+		{
+			{
+				std::unique_lock lock {mutex};
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		stop = true;
+		for (std::thread& t : threads)
+			t.join();
+
+		return nbSharedLocks;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// usage: benchmark-utils [threadCount] [durationMs]
+	const std::size_t nbThreads {argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : std::max<std::size_t>(2, std::thread::hardware_concurrency())};
+	const std::chrono::milliseconds duration {argc > 2 ? std::atoi(argv[2]) : 1000};
+
+	std::cout << nbThreads << " reader threads, shared locks taken in " << duration.count() << "ms with a concurrent writer:" << std::endl;
+	std::cout << "RecursiveSharedMutex (former): " << benchmarkSharedLocks<RecursiveSharedMutex>(nbThreads, duration) << std::endl;
+	std::cout << "std::shared_mutex: " << benchmarkSharedLocks<std::shared_mutex>(nbThreads, duration) << std::endl;
+	std::cout << "RecursiveWriterMutex: " << benchmarkSharedLocks<RecursiveWriterMutex>(nbThreads, duration) << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -269,6 +269,20 @@ int main(int argc, char* argv[])
 			coverService->flushCache();
 		});
 
+		// Keep the recommendations up to date while the scanner is running
+		scannerService->getEvents().tracksRemoved.connect([&](const std::vector<Database::TrackId>& trackIds)
+		{
+			recommendationService->onTracksRemoved(trackIds);
+		});
+		scannerService->getEvents().releasesRemoved.connect([&](const std::vector<Database::ReleaseId>& releaseIds)
+		{
+			recommendationService->onReleasesRemoved(releaseIds);
+		});
+		scannerService->getEvents().artistsRemoved.connect([&](const std::vector<Database::ArtistId>& artistIds)
+		{
+			recommendationService->onArtistsRemoved(artistIds);
+		});
+
 		Service<Scrobbling::IScrobblingService> scrobblingService {Scrobbling::createScrobblingService(ioContext, database)};
 
 		std::unique_ptr<Wt::WResource> subsonicResource;
@@ -309,6 +309,10 @@ PlayQueue::loadTrack(std::size_t pos, bool play)
 		trackId = track->getId();
 
 		replayGain = getReplayGain(pos, track);
+	}
+
+	{
+		auto transaction {LmsApp->getDbSession().createUniqueTransaction()};
 
 		if (!LmsApp->getUser()->isDemo())
 			LmsApp->getUser().modify()->setCurPlayingTrackPos(pos);
@@ -78,6 +78,7 @@ namespace UserInterface
 				Track::FindParameters params;
 				params.setClusters(getFilters().getClusterIds());
 				params.setKeywords(getSearchKeywords());
+				params.setSortMethod(TrackSortMethod::Relevance);
 				params.setRange(range);
 
 				{